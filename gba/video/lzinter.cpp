@@ -0,0 +1,59 @@
+#include "lzinter.h"
+
+namespace Decompress
+{
+
+    IWRAM_FUNC void LZInterUnCompWrite8bit(const uint32_t *source, uint32_t *destination)
+    {
+        // header is (uncompressed size << 8) | type
+        const uint32_t size = *source >> 8;
+        auto src = reinterpret_cast<const uint8_t *>(source + 1);
+        auto dst = reinterpret_cast<uint8_t *>(destination);
+        const auto dstEnd = dst + size;
+        while (dst < dstEnd)
+        {
+            uint32_t flags = *src++;
+            for (uint32_t i = 0; i < 8 && dst < dstEnd; i++, flags <<= 1)
+            {
+                if ((flags & 0x80) == 0)
+                {
+                    // literal
+                    *dst++ = *src++;
+                    continue;
+                }
+                const uint32_t b0 = *src++;
+                if ((b0 & 0x80) != 0)
+                {
+                    // inter-frame match. copy from previous data at or after the current position, which is still in the destination
+                    uint32_t length = (b0 & 0x40) != 0 ? (((b0 & 0x3F) << 8) | *src++) + 67 : (b0 & 0x3F) + 3;
+                    const uint32_t offset = *src++;
+                    if (offset == 0)
+                    {
+                        // unchanged data. nothing to copy
+                        dst += length;
+                    }
+                    else
+                    {
+                        auto copySrc = dst + offset;
+                        do
+                        {
+                            *dst++ = *copySrc++;
+                        } while (--length);
+                    }
+                }
+                else
+                {
+                    // intra-frame match. copy from already decompressed data
+                    uint32_t length = (b0 >> 3) + 3;
+                    const uint32_t displacement = (((b0 & 0x07) << 8) | *src++) + 1;
+                    auto copySrc = dst - displacement;
+                    do
+                    {
+                        *dst++ = *copySrc++;
+                    } while (--length);
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "sys/base.h"
+
+#include <cstdint>
+
+namespace Decompress
+{
+
+    /// @brief Decompress LZ77 with inter-frame matches (see src/compression/lzinter.h), writing 8 bit at a time. Don't use for VRAM
+    /// Decompresses in-place: destination must hold the previous decompressed data, which is overwritten
+    void LZInterUnCompWrite8bit(const uint32_t *source, uint32_t *destination);
+
+}
@@ -0,0 +1,65 @@
+#include "rans.h"
+
+namespace Decompress
+{
+
+    constexpr uint32_t RansScaleBits = 12;
+    constexpr uint32_t RansTotal = 1 << RansScaleBits;
+    constexpr uint32_t RansLowerBound = 1 << 16;
+
+    /// @brief Decoding tables: Symbol for every slot and frequency and first slot of every symbol
+    IWRAM_DATA ALIGN(4) uint8_t RansSymbols[RansTotal];
+    IWRAM_DATA ALIGN(4) uint16_t RansFrequencies[256];
+    IWRAM_DATA ALIGN(4) uint16_t RansStarts[256];
+
+    IWRAM_FUNC void RansUnCompWrite8bit(const uint32_t *source, uint32_t *destination)
+    {
+        // header is (uncompressed size << 8) | type
+        const uint32_t size = *source >> 8;
+        // read frequency table and build slot -> symbol table
+        auto table = reinterpret_cast<const uint8_t *>(source + 1);
+        uint32_t start = 0;
+        for (uint32_t s = 0; s < 256;)
+        {
+            uint32_t frequency = *table++;
+            if (frequency == 0)
+            {
+                // run of unused symbols
+                s += *table++ + 1;
+                continue;
+            }
+            if (frequency & 0x80)
+            {
+                frequency = ((frequency & 0x7F) << 8) | *table++;
+            }
+            RansFrequencies[s] = frequency;
+            RansStarts[s] = start;
+            auto slot = RansSymbols + start;
+            start += frequency;
+            do
+            {
+                *slot++ = s;
+            } while (--frequency);
+            s++;
+        }
+        // frequency table is padded to 4 bytes. initial state follows
+        auto src32 = reinterpret_cast<const uint32_t *>((reinterpret_cast<uintptr_t>(table) + 3) & ~uintptr_t(3));
+        uint32_t state = *src32++;
+        auto src16 = reinterpret_cast<const uint16_t *>(src32);
+        // decode symbols
+        auto dst = reinterpret_cast<uint8_t *>(destination);
+        const auto dstEnd = dst + size;
+        while (dst < dstEnd)
+        {
+            const uint32_t slot = state & (RansTotal - 1);
+            const uint32_t symbol = RansSymbols[slot];
+            *dst++ = symbol;
+            state = RansFrequencies[symbol] * (state >> RansScaleBits) + slot - RansStarts[symbol];
+            if (state < RansLowerBound)
+            {
+                state = (state << 16) | *src16++;
+            }
+        }
+    }
+
+}
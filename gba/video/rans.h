@@ -0,0 +1,14 @@
+#pragma once
+
+#include "sys/base.h"
+
+#include <cstdint>
+
+namespace Decompress
+{
+
+    /// @brief Decompress rANS entropy-coded data (see src/compression/rans.h), writing 8 bit at a time. Don't use for VRAM
+    /// Decoding tables use 5 KB of IWRAM. Portable C++, so it can be compiled and checked on the host too
+    void RansUnCompWrite8bit(const uint32_t *source, uint32_t *destination);
+
+}
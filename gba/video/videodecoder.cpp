@@ -3,6 +3,8 @@
 #include "codec_dxtg.h"
 #include "codec_dxtv.h"
 #include "lz77.h"
+#include "lzinter.h"
+#include "rans.h"
 #include "memory/memory.h"
 #include "sys/base.h"
 #include "sys/decompress.h"
@@ -37,9 +39,19 @@ namespace Video
             case Image::ProcessingType::CompressLz10:
                 dstInVRAM ? Decompress::LZ77UnCompWrite16bit(currentSrc, currentDst) : Decompress::LZ77UnCompWrite8bit(currentSrc, currentDst);
                 break;
+            case Image::ProcessingType::CompressLzInter:
+                // the previous frame was decoded to the same destination, so decode in-place over it
+                Decompress::LZInterUnCompWrite8bit(currentSrc, currentDst);
+                break;
             case Image::ProcessingType::CompressRLE:
                 dstInVRAM ? BIOS::RLUnCompReadNormalWrite16bit(currentSrc, currentDst) : BIOS::RLUnCompReadNormalWrite8bit(currentSrc, currentDst);
                 break;
+            case Image::ProcessingType::CompressHuffman:
+                BIOS::HuffUnCompReadNormal(currentSrc, currentDst);
+                break;
+            case Image::ProcessingType::CompressRANS:
+                Decompress::RansUnCompWrite8bit(currentSrc, currentDst);
+                break;
             case Image::ProcessingType::CompressDXTV:
                 DXTV::UnCompWrite16bit<240>(currentDst, currentSrc, (const uint32_t *)VRAM, info.width, info.height);
                 break;
@@ -2,87 +2,251 @@
 
 #include "color/rgbd.h"
 #include "color/colorhelpers.h"
+#include "compression/dxtclusterfit.h"
 #include "exception.h"
 #include "math/linefit.h"
 
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <iostream>
+#include <limits>
 
 using namespace Color;
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DXT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+    /// @brief Block colors and endpoints as separate R, G, B planes for vectorized distance calculation
+    struct BlockPlanes
+    {
+        alignas(32) std::array<double, 16> R;
+        alignas(32) std::array<double, 16> G;
+        alignas(32) std::array<double, 16> B;
+    };
+
+}
+
+/// @brief Find index of endpoint with the minimum RGBd::distance for each of the 16 colors
+/// @return Returns 2-bit indices of all colors, color #0 in the lowest bits. On equal distance the lower endpoint index wins
+using BestIndicesFunc = auto (*)(const BlockPlanes &colors, const std::array<RGBd, 4> &endpoints) -> uint32_t;
+
+static auto bestIndicesScalar(const BlockPlanes &colors, const std::array<RGBd, 4> &endpoints) -> uint32_t
+{
+    uint32_t indices = 0;
+    for (uint32_t ci = 0; ci < 16; ++ci)
+    {
+        double bestColorDistance = std::numeric_limits<double>::max();
+        uint32_t bestIndex = 0;
+        for (uint32_t ei = 0; ei < 4; ++ei)
+        {
+            // same operations and order as RGBd::distance, so results are bit-identical
+            const double r = 0.5 * (colors.R[ci] + endpoints[ei].R());
+            const double dR = colors.R[ci] - endpoints[ei].R();
+            const double dG = colors.G[ci] - endpoints[ei].G();
+            const double dB = colors.B[ci] - endpoints[ei].B();
+            const double indexDistance = ((2.0 + r) * dR * dR + 4.0 * dG * dG + (3.0 - r) * dB * dB) / 9.0;
+            if (bestColorDistance > indexDistance)
+            {
+                bestColorDistance = indexDistance;
+                bestIndex = ei;
+            }
+        }
+        indices |= bestIndex << (2 * ci);
+    }
+    return indices;
+}
+
+#ifdef DXT_X86_SIMD
+// The SIMD versions compare multiple colors to one endpoint at a time. They must not use FMA instructions to stay bit-identical
+
+__attribute__((target("sse4.1"))) static auto bestIndicesSse41(const BlockPlanes &colors, const std::array<RGBd, 4> &endpoints) -> uint32_t
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d three = _mm_set1_pd(3.0);
+    const __m128d four = _mm_set1_pd(4.0);
+    const __m128d nine = _mm_set1_pd(9.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    uint32_t indices = 0;
+    for (uint32_t ci = 0; ci < 16; ci += 2)
+    {
+        const __m128d cR = _mm_load_pd(colors.R.data() + ci);
+        const __m128d cG = _mm_load_pd(colors.G.data() + ci);
+        const __m128d cB = _mm_load_pd(colors.B.data() + ci);
+        __m128d bestColorDistance = _mm_set1_pd(std::numeric_limits<double>::max());
+        __m128d bestIndex = _mm_setzero_pd();
+        for (uint32_t ei = 0; ei < 4; ++ei)
+        {
+            const __m128d eR = _mm_set1_pd(endpoints[ei].R());
+            const __m128d r = _mm_mul_pd(half, _mm_add_pd(cR, eR));
+            const __m128d dR = _mm_sub_pd(cR, eR);
+            const __m128d dG = _mm_sub_pd(cG, _mm_set1_pd(endpoints[ei].G()));
+            const __m128d dB = _mm_sub_pd(cB, _mm_set1_pd(endpoints[ei].B()));
+            const __m128d sR = _mm_mul_pd(_mm_mul_pd(_mm_add_pd(two, r), dR), dR);
+            const __m128d sG = _mm_mul_pd(_mm_mul_pd(four, dG), dG);
+            const __m128d sB = _mm_mul_pd(_mm_mul_pd(_mm_sub_pd(three, r), dB), dB);
+            const __m128d indexDistance = _mm_div_pd(_mm_add_pd(_mm_add_pd(sR, sG), sB), nine);
+            const __m128d improved = _mm_cmpgt_pd(bestColorDistance, indexDistance);
+            bestColorDistance = _mm_blendv_pd(bestColorDistance, indexDistance, improved);
+            bestIndex = _mm_blendv_pd(bestIndex, _mm_set1_pd(ei), improved);
+        }
+        alignas(16) double best[2];
+        _mm_store_pd(best, bestIndex);
+        indices |= (static_cast<uint32_t>(best[0]) | (static_cast<uint32_t>(best[1]) << 2)) << (2 * ci);
+    }
+    return indices;
+}
+
+__attribute__((target("avx2"))) static auto bestIndicesAvx2(const BlockPlanes &colors, const std::array<RGBd, 4> &endpoints) -> uint32_t
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d three = _mm256_set1_pd(3.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d nine = _mm256_set1_pd(9.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    uint32_t indices = 0;
+    for (uint32_t ci = 0; ci < 16; ci += 4)
+    {
+        const __m256d cR = _mm256_load_pd(colors.R.data() + ci);
+        const __m256d cG = _mm256_load_pd(colors.G.data() + ci);
+        const __m256d cB = _mm256_load_pd(colors.B.data() + ci);
+        __m256d bestColorDistance = _mm256_set1_pd(std::numeric_limits<double>::max());
+        __m256d bestIndex = _mm256_setzero_pd();
+        for (uint32_t ei = 0; ei < 4; ++ei)
+        {
+            const __m256d eR = _mm256_set1_pd(endpoints[ei].R());
+            const __m256d r = _mm256_mul_pd(half, _mm256_add_pd(cR, eR));
+            const __m256d dR = _mm256_sub_pd(cR, eR);
+            const __m256d dG = _mm256_sub_pd(cG, _mm256_set1_pd(endpoints[ei].G()));
+            const __m256d dB = _mm256_sub_pd(cB, _mm256_set1_pd(endpoints[ei].B()));
+            const __m256d sR = _mm256_mul_pd(_mm256_mul_pd(_mm256_add_pd(two, r), dR), dR);
+            const __m256d sG = _mm256_mul_pd(_mm256_mul_pd(four, dG), dG);
+            const __m256d sB = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(three, r), dB), dB);
+            const __m256d indexDistance = _mm256_div_pd(_mm256_add_pd(_mm256_add_pd(sR, sG), sB), nine);
+            const __m256d improved = _mm256_cmp_pd(bestColorDistance, indexDistance, _CMP_GT_OQ);
+            bestColorDistance = _mm256_blendv_pd(bestColorDistance, indexDistance, improved);
+            bestIndex = _mm256_blendv_pd(bestIndex, _mm256_set1_pd(ei), improved);
+        }
+        // convert indices to integers and pack them into 8 bits
+        const __m128i best = _mm256_cvtpd_epi32(bestIndex);
+        const uint32_t packed = _mm_cvtsi128_si32(best) | (_mm_extract_epi32(best, 1) << 2) | (_mm_extract_epi32(best, 2) << 4) | (_mm_extract_epi32(best, 3) << 6);
+        indices |= packed << (2 * ci);
+    }
+    return indices;
+}
+#endif
+
+/// @brief Select the fastest function the CPU supports
+static auto getBestIndicesFunc() -> BestIndicesFunc
+{
+#ifdef DXT_X86_SIMD
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return bestIndicesAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return bestIndicesSse41;
+    }
+#endif
+    return bestIndicesScalar;
+}
+
+static const BestIndicesFunc BestIndices = getBestIndicesFunc();
+
 // This is basically the "range fit" method from here: http://www.sjbrown.co.uk/2006/01/19/dxt-compression-techniques/
-std::vector<uint8_t> DXT::encodeBlockDXTG2(const uint16_t *start, uint32_t pixelsPerScanline)
+auto DXT::encodeBlockDXTG(const uint16_t *start, uint32_t pixelsPerScanline, uint16_t *colorsDst, uint32_t *indicesDst) -> void
 {
-    REQUIRE(pixelsPerScanline % 4 == 0, std::runtime_error, "Image width must be a multiple of 4 for DXT compression");
     // get block colors for all 16 pixels
     std::array<RGBd, 16> colors;
-    auto cIt = colors.begin();
+    BlockPlanes planes;
     auto pixel = start;
-    for (int y = 0; y < 4; y++)
+    for (uint32_t y = 0; y < 4; y++)
     {
-        *cIt++ = RGBd::fromRGB555(pixel[0]);
-        *cIt++ = RGBd::fromRGB555(pixel[1]);
-        *cIt++ = RGBd::fromRGB555(pixel[2]);
-        *cIt++ = RGBd::fromRGB555(pixel[3]);
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            const auto ci = y * 4 + x;
+            colors[ci] = RGBd::fromRGB555(pixel[x]);
+            planes.R[ci] = colors[ci].R();
+            planes.G[ci] = colors[ci].G();
+            planes.B[ci] = colors[ci].B();
+        }
         pixel += pixelsPerScanline;
     }
+    // single-color blocks are common in video. the line fit can not change the result, all colors get index 0
+    if (std::all_of(colors.cbegin(), colors.cend(), [&c = colors.front()](const auto &color)
+                    { return color == c; }))
+    {
+        colorsDst[0] = toBGR555(colors.front().toRGB555());
+        colorsDst[1] = colorsDst[0];
+        *indicesDst = 0;
+        return;
+    }
     // calculate line fit through RGB color space
-    auto originAndAxis = lineFit(colors);
-    // calculate signed distance from origin
-    std::vector<double> distanceFromOrigin(16);
-    std::transform(colors.cbegin(), colors.cend(), distanceFromOrigin.begin(), [origin = originAndAxis.first, axis = originAndAxis.second](const auto &color)
-                   { return color.dot(axis); });
-    // get the distance of endpoints c0 and c1 on line
-    auto minMaxDistance = std::minmax_element(distanceFromOrigin.cbegin(), distanceFromOrigin.cend());
-    auto indexC0 = std::distance(distanceFromOrigin.cbegin(), minMaxDistance.first);
-    auto indexC1 = std::distance(distanceFromOrigin.cbegin(), minMaxDistance.second);
-    // get colors c0 and c1 on line and round to grid
-    auto c0 = colors[indexC0];
-    auto c1 = colors[indexC1];
-    RGBd endpoints[4] = {c0, c1, {}, {}};
-    /*if (toPixel(endpoints[0]) > toPixel(endpoints[1]))
+    const auto axis = lineFit(colors).second;
+    // get the colors with minimum and maximum signed distance from origin on line. these are endpoints c0 and c1
+    uint32_t indexC0 = 0;
+    uint32_t indexC1 = 0;
+    double minDistance = colors[0].dot(axis);
+    double maxDistance = minDistance;
+    for (uint32_t ci = 1; ci < 16; ++ci)
     {
-        std::swap(c0, c1);
-        std::swap(endpoints[0], endpoints[1]);
-    }*/
+        // first minimum and last maximum like std::minmax_element
+        const double distanceFromOrigin = colors[ci].dot(axis);
+        if (distanceFromOrigin < minDistance)
+        {
+            minDistance = distanceFromOrigin;
+            indexC0 = ci;
+        }
+        if (distanceFromOrigin >= maxDistance)
+        {
+            maxDistance = distanceFromOrigin;
+            indexC1 = ci;
+        }
+    }
+    const auto &c0 = colors[indexC0];
+    const auto &c1 = colors[indexC1];
     // calculate intermediate colors c2 and c3 (rounded like in decoder)
-    endpoints[2] = RGBd::roundToRGB555(RGBd((c0.cwiseProduct(RGBd(2, 2, 2)) + c1).cwiseQuotient(RGBd(3, 3, 3))));
-    endpoints[3] = RGBd::roundToRGB555(RGBd((c0 + c1.cwiseProduct(RGBd(2, 2, 2))).cwiseQuotient(RGBd(3, 3, 3))));
-    // calculate minimum distance for all colors to endpoints
-    std::array<uint32_t, 16> bestIndices = {0};
-    for (uint32_t ci = 0; ci < 16; ++ci)
+    const std::array<RGBd, 4> endpoints = {c0, c1,
+                                           RGBd::roundToRGB555(RGBd((c0.cwiseProduct(RGBd(2, 2, 2)) + c1).cwiseQuotient(RGBd(3, 3, 3)))),
+                                           RGBd::roundToRGB555(RGBd((c0 + c1.cwiseProduct(RGBd(2, 2, 2))).cwiseQuotient(RGBd(3, 3, 3))))};
+    // store color endpoints c0 and c1 and the index of the closest endpoint for all colors
+    colorsDst[0] = toBGR555(c0.toRGB555());
+    colorsDst[1] = toBGR555(c1.toRGB555());
+    *indicesDst = BestIndices(planes, endpoints);
+}
+
+auto DXT::encodeBlockDXTGClusterFit(const uint16_t *start, uint32_t pixelsPerScanline, uint16_t *colorsDst, uint32_t *indicesDst) -> void
+{
+    // get block colors for all 16 pixels
+    std::array<RGBd, 16> colors;
+    auto pixel = start;
+    for (uint32_t y = 0; y < 4; y++)
     {
-        // calculate minimum distance for each index for this color
-        double bestColorDistance = std::numeric_limits<double>::max();
-        for (uint32_t ei = 0; ei < 4; ++ei)
+        for (uint32_t x = 0; x < 4; x++)
         {
-            auto indexDistance = RGBd::distance(colors[ci], endpoints[ei]);
-            // check if result improved
-            if (bestColorDistance > indexDistance)
-            {
-                bestColorDistance = indexDistance;
-                bestIndices[ci] = ei;
-            }
+            colors[y * 4 + x] = RGBd::fromRGB555(pixel[x]);
         }
+        pixel += pixelsPerScanline;
     }
-    // build result data
-    std::vector<uint8_t> result(2 * 2 + 16 * 2 / 8);
-    // add color endpoints c0 and c1
-    auto data16 = reinterpret_cast<uint16_t *>(result.data());
-    *data16++ = toBGR555(endpoints[0].toRGB555());
-    *data16++ = toBGR555(endpoints[1].toRGB555());
+    const auto endpoints = DXTClusterFit<RGBd, 16>::encode(colors);
+    colorsDst[0] = toBGR555(endpoints.color0);
+    colorsDst[1] = toBGR555(endpoints.color1);
     // add index data in reverse
     uint32_t indices = 0;
-    for (auto iIt = bestIndices.crbegin(); iIt != bestIndices.crend(); ++iIt)
+    for (auto iIt = endpoints.indices.crbegin(); iIt != endpoints.indices.crend(); ++iIt)
     {
         indices = (indices << 2) | *iIt;
     }
-    *(reinterpret_cast<uint32_t *>(data16)) = indices;
-    return result;
+    *indicesDst = indices;
 }
 
 /*using Cluster = std::pair<RGBd, std::vector<RGBd>>;
@@ -209,43 +373,27 @@ for (auto iIt = bestIndices.crbegin(); iIt != bestIndices.crend(); ++iIt)
 return result;
 }*/
 
-auto DXT::encodeDXTG(const std::vector<uint16_t> &image, uint32_t width, uint32_t height) -> std::vector<uint8_t>
+auto DXT::encodeDXTG(const std::vector<uint16_t> &image, uint32_t width, uint32_t height, bool clusterFit) -> std::vector<uint8_t>
 {
     REQUIRE(width % 4 == 0, std::runtime_error, "Image width must be a multiple of 4 for DXT compression");
     REQUIRE(height % 4 == 0, std::runtime_error, "Image height must be a multiple of 4 for DXT compression");
-    // build y-position table for parallel for
-    std::vector<uint32_t> ys(height / 4);
-    std::generate(ys.begin(), ys.end(), [y = 0]() mutable
-                  {
-                          y += 4;
-                          return y - 4; });
-    // compress to DXT1. we get 8 bytes per 4x4 block / 16 pixels
-    const auto yStride = width * 8 / 16;
+    // compress to DXT1. we get 8 bytes per 4x4 block / 16 pixels.
+    // split data into colors and indices for better compression. first all colors, then all indices
     const auto nrOfBlocks = width / 4 * height / 4;
-    std::vector<uint8_t> dxtData(nrOfBlocks * 8);
-#pragma omp parallel for
-    for (int y = 0; y < height; y += 4)
+    std::vector<uint8_t> data(nrOfBlocks * 8);
+    auto colorPtr16 = reinterpret_cast<uint16_t *>(data.data());
+    auto indexPtr32 = reinterpret_cast<uint32_t *>(data.data() + nrOfBlocks * 4);
+    const auto encodeBlock = clusterFit ? encodeBlockDXTGClusterFit : encodeBlockDXTG;
+    // cluster fit run time differs a lot between blocks, so distribute rows dynamically
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int y = 0; y < static_cast<int>(height); y += 4)
     {
         for (uint32_t x = 0; x < width; x += 4)
         {
-            auto block = encodeBlockDXTG2(image.data() + y * width + x, width);
-            std::copy(block.cbegin(), block.cend(), std::next(dxtData.begin(), y * yStride + x * 8 / 4));
+            const auto blockIndex = y / 4 * (width / 4) + x / 4;
+            encodeBlock(image.data() + y * width + x, width, colorPtr16 + blockIndex * 2, indexPtr32 + blockIndex);
         }
     }
-    // split data into colors and indices for better compression
-    std::vector<uint8_t> data(nrOfBlocks * 8);
-    // std::vector<uint16_t> RGBdata(nrOfBlocks * 2);
-    auto colorPtr16 = reinterpret_cast<uint16_t *>(data.data());
-    // std::vector<uint16_t> indexData(nrOfBlocks * 2);
-    auto indexPtr16 = reinterpret_cast<uint16_t *>(data.data() + nrOfBlocks * 4);
-    auto srcPtr16 = reinterpret_cast<const uint16_t *>(dxtData.data());
-    for (uint32_t i = 0; i < nrOfBlocks; i++)
-    {
-        *colorPtr16++ = *srcPtr16++;
-        *colorPtr16++ = *srcPtr16++;
-        *indexPtr16++ = *srcPtr16++;
-        *indexPtr16++ = *srcPtr16++;
-    }
     /*auto srcPtr16 = reinterpret_cast<const uint16_t *>(resultData.data());
     std::vector<uint16_t> uniqueColors;
     for (uint32_t i = 0; i < nrOfBlocks * 2; i++)
@@ -11,12 +11,17 @@ public:
     /// Differences:
     /// - Colors will be stored as RGB555 only
     /// - Blocks are stored sequentially from left to right, top to bottom, but colors and indices are stored separately. First all colors, then all indices
-    static auto encodeDXTG(const std::vector<uint16_t> &image, uint32_t width, uint32_t height) -> std::vector<uint8_t>;
+    /// @param clusterFit If true use the slower, higher-quality cluster fit to find block endpoints, else range fit
+    static auto encodeDXTG(const std::vector<uint16_t> &image, uint32_t width, uint32_t height, bool clusterFit = false) -> std::vector<uint8_t>;
 
     /// @brief Decompress from DXTG format.
     static auto decodeDXTG(const std::vector<uint8_t> &data, uint32_t width, uint32_t height) -> std::vector<uint8_t>;
 
 private:
-    static std::vector<uint8_t> encodeBlockDXTG2(const uint16_t *start, uint32_t pixelsPerScanline);
+    /// @brief Compress a 4x4 block using range fit and store colors c0, c1 and the indices at the destinations
+    static auto encodeBlockDXTG(const uint16_t *start, uint32_t pixelsPerScanline, uint16_t *colorsDst, uint32_t *indicesDst) -> void;
+
+    /// @brief Compress a 4x4 block using cluster fit and store colors c0, c1 and the indices at the destinations
+    static auto encodeBlockDXTGClusterFit(const uint16_t *start, uint32_t pixelsPerScanline, uint16_t *colorsDst, uint32_t *indicesDst) -> void;
     // static std::vector<uint8_t> encodeBlockDXTG3(const uint16_t *start, uint32_t pixelsPerScanline);
 };
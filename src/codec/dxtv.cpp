@@ -9,13 +9,17 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <type_traits>
 #include <vector>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 using namespace Color;
 
@@ -101,6 +105,169 @@ static auto distanceBelowThreshold(const BlockView<YCgCoRd, BLOCK_DIM> &a, const
     return {belowThreshold, dist / (BLOCK_DIM * BLOCK_DIM)};
 }
 
+namespace
+{
+
+    /// @brief Mean and standard deviation of block colors in a space where YCgCoRd::distance is the squared euclidean distance.
+    /// Used to calculate a lower bound for the distance between blocks without looking at their pixels (see lowerBounds())
+    struct BlockStatistics
+    {
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero(); // Mean of weighted colors
+        double deviation = 0;                           // Square root of mean squared distance of weighted colors to mean
+
+        /// @brief Weights that turn YCgCoRd::distance into a squared euclidean distance
+        static auto weighted(const YCgCoRd &color) -> Eigen::Vector3d
+        {
+            return {color.Y() * std::sqrt(0.5), color.Cg() * 0.25, color.Co() * 0.25};
+        }
+
+        /// @brief Calculate statistics for block colors
+        template <std::size_t BLOCK_DIM>
+        static auto fromBlock(const BlockView<YCgCoRd, BLOCK_DIM> &block) -> BlockStatistics
+        {
+            BlockStatistics result;
+            for (auto cIt = block.cbegin(); cIt != block.cend(); ++cIt)
+            {
+                result.mean += weighted(*cIt);
+            }
+            result.mean /= static_cast<double>(BLOCK_DIM * BLOCK_DIM);
+            double sum = 0;
+            for (auto cIt = block.cbegin(); cIt != block.cend(); ++cIt)
+            {
+                sum += (weighted(*cIt) - result.mean).squaredNorm();
+            }
+            result.deviation = std::sqrt(sum / (BLOCK_DIM * BLOCK_DIM));
+            return result;
+        }
+    };
+
+    /// @brief Relative tolerance for comparing lower bounds to distances, so rounding errors never reject a block that should be found
+    constexpr double LowerBoundTolerance = 1e-9;
+
+    /// @brief Structure-of-arrays storage of weighted block colors (see BlockStatistics::weighted) as float planes of Y, Cg and Co
+    /// and of block statistics. All pixels of a block are stored consecutively, so block distances and lower bounds for
+    /// many blocks can be calculated with SIMD instructions
+    template <std::size_t BLOCK_DIM>
+    struct BlockPlanes
+    {
+        static constexpr std::size_t PixelsPerBlock = BLOCK_DIM * BLOCK_DIM;
+        std::vector<float> Y;
+        std::vector<float> Cg;
+        std::vector<float> Co;
+        std::vector<double> meanY;
+        std::vector<double> meanCg;
+        std::vector<double> meanCo;
+        std::vector<double> deviation;
+
+        /// @brief Reserve space for a number of blocks
+        auto reserve(std::size_t nrOfBlocks) -> void
+        {
+            Y.reserve(nrOfBlocks * PixelsPerBlock);
+            Cg.reserve(nrOfBlocks * PixelsPerBlock);
+            Co.reserve(nrOfBlocks * PixelsPerBlock);
+            meanY.reserve(nrOfBlocks);
+            meanCg.reserve(nrOfBlocks);
+            meanCo.reserve(nrOfBlocks);
+            deviation.reserve(nrOfBlocks);
+        }
+
+        /// @brief Append colors and statistics of block to the planes
+        auto push_back(const BlockView<YCgCoRd, BLOCK_DIM> &block, const BlockStatistics &statistics) -> void
+        {
+            meanY.push_back(statistics.mean.x());
+            meanCg.push_back(statistics.mean.y());
+            meanCo.push_back(statistics.mean.z());
+            deviation.push_back(statistics.deviation);
+            for (auto cIt = block.cbegin(); cIt != block.cend(); ++cIt)
+            {
+                const auto color = BlockStatistics::weighted(*cIt);
+                Y.push_back(static_cast<float>(color.x()));
+                Cg.push_back(static_cast<float>(color.y()));
+                Co.push_back(static_cast<float>(color.z()));
+            }
+        }
+    };
+
+    /// @brief Calculate lower bounds for the block distances returned by distance() and distanceBelowThreshold() between a block and a range of codebook blocks.
+    /// The summed squared distance of N colors a, b is N * |mean(a) - mean(b)|^2 + |a - mean(a) - (b - mean(b))|^2
+    /// and the second term is >= N * (deviation(a) - deviation(b))^2 due to the triangle inequality.
+    /// Bounds are reduced by LowerBoundTolerance
+    /// @param block Statistics of the block to compare to
+    /// @param planes Planes of codebook blocks
+    /// @param first Index of first codebook block to compare to
+    /// @param count Number of codebook blocks to compare to
+    /// @param bounds Receives lower bound per codebook block
+    template <std::size_t BLOCK_DIM>
+    auto lowerBounds(const BlockStatistics &block, const BlockPlanes<BLOCK_DIM> &planes, std::size_t first, std::size_t count, double *bounds) -> void
+    {
+        const double meanY = block.mean.x();
+        const double meanCg = block.mean.y();
+        const double meanCo = block.mean.z();
+        const double deviation = block.deviation;
+        const double *bMeanY = planes.meanY.data() + first;
+        const double *bMeanCg = planes.meanCg.data() + first;
+        const double *bMeanCo = planes.meanCo.data() + first;
+        const double *bDeviation = planes.deviation.data() + first;
+#pragma omp simd
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const double dY = meanY - bMeanY[i];
+            const double dCg = meanCg - bMeanCg[i];
+            const double dCo = meanCo - bMeanCo[i];
+            const double dDeviation = deviation - bDeviation[i];
+            bounds[i] = (dY * dY + dCg * dCg + dCo * dCo + dDeviation * dDeviation) * (1.0 - LowerBoundTolerance);
+        }
+    }
+
+    /// @brief Relative and absolute tolerance for comparing approximate float distances to distances.
+    /// Float rounding errors of a pixel distance d are < 1e-6 * sqrt(d) + 2e-5 * d, so these never reject a block that should be found
+    constexpr double ApproximateDistanceTolerance = 1e-3;
+    constexpr double ApproximateDistanceEpsilon = 1e-9;
+
+    /// @brief Check if an approximate float distance is definitely above a distance limit
+    auto approximateDistanceAbove(float approximateDistance, double limit) -> bool
+    {
+        return static_cast<double>(approximateDistance) > limit * (1.0 + ApproximateDistanceTolerance) + ApproximateDistanceEpsilon;
+    }
+
+    /// @brief Calculate approximate perceived pixel difference between a block and multiple codebook blocks in float precision
+    /// @param block Planes holding only the block to compare to
+    /// @param planes Planes of codebook blocks
+    /// @param indices Indices of codebook blocks to compare to
+    /// @param count Number of codebook blocks to compare to
+    /// @param distances Receives mean pixel distance per codebook block
+    /// @param maxDistances Receives maximum pixel distance per codebook block
+    template <std::size_t BLOCK_DIM>
+    auto approximateDistances(const BlockPlanes<BLOCK_DIM> &block, const BlockPlanes<BLOCK_DIM> &planes, const int32_t *indices, std::size_t count, float *distances, float *maxDistances) -> void
+    {
+        constexpr std::size_t N = BlockPlanes<BLOCK_DIM>::PixelsPerBlock;
+        const float *aY = block.Y.data();
+        const float *aCg = block.Cg.data();
+        const float *aCo = block.Co.data();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const float *bY = planes.Y.data() + indices[i] * N;
+            const float *bCg = planes.Cg.data() + indices[i] * N;
+            const float *bCo = planes.Co.data() + indices[i] * N;
+            float sum = 0;
+            float maxDistance = 0;
+#pragma omp simd reduction(+ : sum) reduction(max : maxDistance)
+            for (std::size_t p = 0; p < N; p++)
+            {
+                const float dY = aY[p] - bY[p];
+                const float dCg = aCg[p] - bCg[p];
+                const float dCo = aCo[p] - bCo[p];
+                const float colorDist = dY * dY + dCg * dCg + dCo * dCo;
+                sum += colorDist;
+                maxDistance = maxDistance > colorDist ? maxDistance : colorDist;
+            }
+            distances[i] = sum / N;
+            maxDistances[i] = maxDistance;
+        }
+    }
+
+}
+
 /// @brief List of code book entries representing the image
 class CodeBook
 {
@@ -143,6 +310,15 @@ public:
                 m_blocks2.emplace_back(block_type2(m_colors.data(), m_width, m_height, x, y));
             }
         }
+        m_planes0.reserve(m_blocks0.size());
+        m_planes1.reserve(m_blocks1.size());
+        m_planes2.reserve(m_blocks2.size());
+        std::for_each(m_blocks0.cbegin(), m_blocks0.cend(), [this](const auto &block)
+                      { m_planes0.push_back(block, BlockStatistics::fromBlock(block)); });
+        std::for_each(m_blocks1.cbegin(), m_blocks1.cend(), [this](const auto &block)
+                      { m_planes1.push_back(block, BlockStatistics::fromBlock(block)); });
+        std::for_each(m_blocks2.cbegin(), m_blocks2.cend(), [this](const auto &block)
+                      { m_planes2.push_back(block, BlockStatistics::fromBlock(block)); });
         m_encoded0 = std::vector<bool>(m_width / BlockMaxDim * m_height / BlockMaxDim, encoded);
         m_encoded1 = std::vector<bool>(m_width / (BlockMaxDim / 2) * m_height / (BlockMaxDim / 2), encoded);
         m_encoded2 = std::vector<bool>(m_width / (BlockMaxDim / 4) * m_height / (BlockMaxDim / 4), encoded);
@@ -256,6 +432,24 @@ public:
         }
     }
 
+    /// @brief Get float color planes and statistics of all blocks at specific level
+    template <std::size_t BLOCK_DIM>
+    auto planes() const -> const BlockPlanes<BLOCK_DIM> &
+    {
+        if constexpr (BLOCK_DIM == decltype(m_blocks0)::value_type::Dim)
+        {
+            return m_planes0;
+        }
+        else if constexpr (BLOCK_DIM == decltype(m_blocks1)::value_type::Dim)
+        {
+            return m_planes1;
+        }
+        else if constexpr (BLOCK_DIM == decltype(m_blocks2)::value_type::Dim)
+        {
+            return m_planes2;
+        }
+    }
+
     template <std::size_t BLOCK_DIM>
     auto isEncoded(const BlockView<YCgCoRd, BLOCK_DIM> &block) const
     {
@@ -273,6 +467,23 @@ public:
         }
     }
 
+    template <std::size_t BLOCK_DIM>
+    auto isEncoded(std::size_t index) const
+    {
+        if constexpr (BLOCK_DIM == decltype(m_blocks0)::value_type::Dim)
+        {
+            return m_encoded0[index];
+        }
+        else if constexpr (BLOCK_DIM == decltype(m_blocks1)::value_type::Dim)
+        {
+            return m_encoded1[index];
+        }
+        else if constexpr (BLOCK_DIM == decltype(m_blocks2)::value_type::Dim)
+        {
+            return m_encoded2[index];
+        }
+    }
+
     template <std::size_t BLOCK_DIM>
     auto setEncoded(const BlockView<YCgCoRd, BLOCK_DIM> &block, bool encoded = true)
     {
@@ -328,6 +539,9 @@ private:
     std::vector<block_type0> m_blocks0;
     std::vector<block_type1> m_blocks1;
     std::vector<block_type2> m_blocks2;
+    BlockPlanes<BlockMaxDim> m_planes0;
+    BlockPlanes<BlockMaxDim / 2> m_planes1;
+    BlockPlanes<BlockMaxDim / 4> m_planes2;
     std::vector<bool> m_encoded0;
     std::vector<bool> m_encoded1;
     std::vector<bool> m_encoded2;
@@ -355,40 +569,79 @@ auto findBestMatchingBlock(const CodeBook &codeBook, const BlockView<CodeBook::v
     {
         return std::optional<return_type>();
     }
-    // find blocks that are already encoded in codebook and calculate distance to block
+    // find blocks that are already encoded in codebook and calculate a lower bound for their distance to block.
+    // if the mean pixel distance is above the threshold, at least one pixel is too, so the block can not be used
+    const auto &codeBookPlanes = codeBook.planes<BLOCK_DIM>();
+    const auto blockStatistics = BlockStatistics::fromBlock(block);
+    std::vector<double> bounds(maxIndex - minIndex);
+    lowerBounds(blockStatistics, codeBookPlanes, minIndex, bounds.size(), bounds.data());
     std::vector<std::pair<double, int32_t>> candidates;
-    auto cIt = std::next(codeBook.cbegin<BLOCK_DIM>(), minIndex);
-    auto cEnd = std::next(codeBook.cbegin<BLOCK_DIM>(), maxIndex);
-    for (int32_t index = minIndex; cIt != cEnd; ++cIt, ++index)
+    for (int32_t index = minIndex; index < maxIndex; ++index)
+    {
+        if (const auto bound = bounds[index - minIndex]; bound < maxAllowedError && codeBook.isEncoded<BLOCK_DIM>(index))
+        {
+            candidates.push_back({bound, index});
+        }
+    }
+    // calculate distances in order of increasing lower bound until no remaining block can be better.
+    // distances are approximated in float precision for a batch of blocks first and only blocks that might be usable
+    // or better than the current best block are checked exactly. on equal distance the block with the smaller index wins
+    std::sort(candidates.begin(), candidates.end());
+    BlockPlanes<BLOCK_DIM> blockPlanes;
+    blockPlanes.push_back(block, blockStatistics);
+    constexpr std::size_t BatchSize = 8;
+    std::array<int32_t, BatchSize> batchIndices;
+    std::array<float, BatchSize> batchDistances;
+    std::array<float, BatchSize> batchMaxDistances;
+    double bestDistance = std::numeric_limits<double>::max();
+    int32_t bestIndex = -1;
+    for (std::size_t batchStart = 0; batchStart < candidates.size() && candidates[batchStart].first <= bestDistance; batchStart += BatchSize)
     {
-        if (codeBook.isEncoded(*cIt))
+        const auto batchCount = std::min(BatchSize, candidates.size() - batchStart);
+        for (std::size_t i = 0; i < batchCount; i++)
+        {
+            batchIndices[i] = candidates[batchStart + i].second;
+        }
+        approximateDistances(blockPlanes, codeBookPlanes, batchIndices.data(), batchCount, batchDistances.data(), batchMaxDistances.data());
+        for (std::size_t i = 0; i < batchCount; i++)
         {
-            if (auto dist = distanceBelowThreshold(block, *cIt, maxAllowedError); dist.first)
+            const auto &candidate = candidates[batchStart + i];
+            if (candidate.first > bestDistance)
+            {
+                break;
+            }
+            if (approximateDistanceAbove(batchMaxDistances[i], maxAllowedError) || approximateDistanceAbove(batchDistances[i], bestDistance))
             {
-                candidates.push_back({dist.second, index});
+                continue;
+            }
+            const auto &candidateBlock = *std::next(codeBook.cbegin<BLOCK_DIM>(), candidate.second);
+            if (auto dist = distanceBelowThreshold(block, candidateBlock, maxAllowedError); dist.first)
+            {
+                if (dist.second < bestDistance || (dist.second == bestDistance && candidate.second < bestIndex))
+                {
+                    bestDistance = dist.second;
+                    bestIndex = candidate.second;
+                }
             }
         }
     }
-    // find block that has minimum error
-    auto bestCandiateIt = std::min_element(candidates.cbegin(), candidates.cend(), [](const auto &a, const auto &b)
-                                           { return a.first < b.first; });
-    return (bestCandiateIt != candidates.cend()) ? std::optional<return_type>({bestCandiateIt->first, *std::next(codeBook.cbegin<BLOCK_DIM>(), bestCandiateIt->second)}) : std::optional<return_type>();
+    return bestIndex >= 0 ? std::optional<return_type>({bestDistance, *std::next(codeBook.cbegin<BLOCK_DIM>(), bestIndex)}) : std::optional<return_type>();
 }
 
+/// @brief Block statistics of one frame
 struct Statistics
 {
-    std::array<uint32_t, 3> refBlocksCurr;
-    std::array<uint32_t, 3> refBlocksPrev;
-    std::array<uint32_t, 3> dxtBlocks;
+    std::array<uint32_t, 3> refBlocksCurr = {};
+    std::array<uint32_t, 3> refBlocksPrev = {};
+    std::array<uint32_t, 3> dxtBlocks = {};
 };
 
-Statistics statistics;
-
 /// @brief Store state of compression of one frame
 struct CompressionState
 {
     std::vector<bool> flags;   // block flags store flags for blocks (2 bit per block of any size)
     std::vector<uint8_t> data; // stores block references and DXT data
+    Statistics statistics;     // block statistics for frame. Kept per frame so frames can be encoded in parallel
 };
 
 template <std::size_t BLOCK_DIM>
@@ -399,7 +652,7 @@ auto storeDxtBlock(CodeBook &currentCodeBook, BlockView<CodeBook::value_type, BL
     std::copy(dxtData.cbegin(), dxtData.cend(), std::back_inserter(state.data));
     // mark block as encoded
     currentCodeBook.setEncoded<BLOCK_DIM>(block);
-    statistics.dxtBlocks[BLOCK_LEVEL]++;
+    state.statistics.dxtBlocks[BLOCK_LEVEL]++;
 }
 
 template <std::size_t BLOCK_DIM>
@@ -412,12 +665,12 @@ auto storeRefBlock(CodeBook &currentCodeBook, BlockView<CodeBook::value_type, BL
     if (fromPrevCodeBook)
     {
         index |= BLOCK_IS_REF | BLOCK_FROM_PREV;
-        statistics.refBlocksPrev[BLOCK_LEVEL]++;
+        state.statistics.refBlocksPrev[BLOCK_LEVEL]++;
     }
     else
     {
         index |= BLOCK_IS_REF | BLOCK_FROM_CURR;
-        statistics.refBlocksCurr[BLOCK_LEVEL]++;
+        state.statistics.refBlocksCurr[BLOCK_LEVEL]++;
     }
     state.data.push_back(index & 0xFF);
     state.data.push_back((index >> 8) & 0xFF);
@@ -425,8 +678,53 @@ auto storeRefBlock(CodeBook &currentCodeBook, BlockView<CodeBook::value_type, BL
     currentCodeBook.setEncoded<BLOCK_DIM>(block);
 }
 
+/// @brief DXT-encoded blocks of all block sizes of a frame. Used with cluster fit, which is slow enough to encode all blocks up front in parallel
+struct EncodedBlocks
+{
+    std::vector<DXTBlock<CodeBook::BlockMaxDim, CodeBook::BlockMaxDim>> blocks0;
+    std::vector<DXTBlock<CodeBook::BlockMaxDim / 2, CodeBook::BlockMaxDim / 2>> blocks1;
+    std::vector<DXTBlock<CodeBook::BlockMaxDim / 4, CodeBook::BlockMaxDim / 4>> blocks2;
+
+    /// @brief Get encoded blocks of a specific size
+    template <std::size_t BLOCK_DIM>
+    auto get() -> std::vector<DXTBlock<BLOCK_DIM, BLOCK_DIM>> &
+    {
+        if constexpr (BLOCK_DIM == CodeBook::BlockMaxDim)
+        {
+            return blocks0;
+        }
+        else if constexpr (BLOCK_DIM == CodeBook::BlockMaxDim / 2)
+        {
+            return blocks1;
+        }
+        else if constexpr (BLOCK_DIM == CodeBook::BlockMaxDim / 4)
+        {
+            return blocks2;
+        }
+    }
+
+    template <std::size_t BLOCK_DIM>
+    auto get() const -> const std::vector<DXTBlock<BLOCK_DIM, BLOCK_DIM>> &
+    {
+        return const_cast<EncodedBlocks *>(this)->get<BLOCK_DIM>();
+    }
+};
+
+/// @brief Cluster-fit encode all blocks of a specific size in a codebook
+template <std::size_t BLOCK_DIM>
+auto encodeAllBlocks(const CodeBook &codeBook, EncodedBlocks &encodedBlocks) -> void
+{
+    auto &blocks = encodedBlocks.get<BLOCK_DIM>();
+    blocks.resize(codeBook.size<BLOCK_DIM>());
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < static_cast<int>(blocks.size()); i++)
+    {
+        blocks[i] = DXTBlock<BLOCK_DIM, BLOCK_DIM>::encode(std::next(codeBook.cbegin<BLOCK_DIM>(), i)->colors(), true);
+    }
+}
+
 template <std::size_t BLOCK_DIM>
-auto encodeBlock(CodeBook &currentCodeBook, const CodeBook &previousCodeBook, BlockView<CodeBook::value_type, BLOCK_DIM> &block, CompressionState &state, double maxAllowedError) -> void
+auto encodeBlock(CodeBook &currentCodeBook, const CodeBook &previousCodeBook, BlockView<CodeBook::value_type, BLOCK_DIM> &block, CompressionState &state, double maxAllowedError, const EncodedBlocks *encodedBlocks) -> void
 {
     static constexpr std::size_t BLOCK_LEVEL = std::log2(CodeBook::BlockMaxDim) - std::log2(BLOCK_DIM);
     // Try to reference block from the previous code book (if available) within error
@@ -460,7 +758,7 @@ auto encodeBlock(CodeBook &currentCodeBook, const CodeBook &previousCodeBook, Bl
     {
         // No good references found. DXT-encode full block
         auto rawBlock = block.colors();
-        auto encodedBlock = DXTBlock<BLOCK_DIM, BLOCK_DIM>::encode(rawBlock);
+        auto encodedBlock = encodedBlocks != nullptr ? encodedBlocks->get<BLOCK_DIM>()[block.index()] : DXTBlock<BLOCK_DIM, BLOCK_DIM>::encode(rawBlock);
         auto decodedBlock = DXTBlock<BLOCK_DIM, BLOCK_DIM>::decode(encodedBlock);
         if constexpr (BLOCK_DIM <= CodeBook::BlockMinDim)
         {
@@ -481,16 +779,16 @@ auto encodeBlock(CodeBook &currentCodeBook, const CodeBook &previousCodeBook, Bl
             {
                 // Split block and recurse
                 state.flags.push_back(BLOCK_IS_SPLIT);
-                encodeBlock(currentCodeBook, previousCodeBook, block.block(0), state, maxAllowedError);
-                encodeBlock(currentCodeBook, previousCodeBook, block.block(1), state, maxAllowedError);
-                encodeBlock(currentCodeBook, previousCodeBook, block.block(2), state, maxAllowedError);
-                encodeBlock(currentCodeBook, previousCodeBook, block.block(3), state, maxAllowedError);
+                encodeBlock(currentCodeBook, previousCodeBook, block.block(0), state, maxAllowedError, encodedBlocks);
+                encodeBlock(currentCodeBook, previousCodeBook, block.block(1), state, maxAllowedError, encodedBlocks);
+                encodeBlock(currentCodeBook, previousCodeBook, block.block(2), state, maxAllowedError, encodedBlocks);
+                encodeBlock(currentCodeBook, previousCodeBook, block.block(3), state, maxAllowedError, encodedBlocks);
             }
         }
     }
 }
 
-auto DXTV::encodeDXTV(const std::vector<uint16_t> &image, const std::vector<uint16_t> &previousImage, uint32_t width, uint32_t height, bool keyFrame, double maxBlockError) -> std::pair<std::vector<uint8_t>, std::vector<uint16_t>>
+auto DXTV::encodeDXTV(const std::vector<uint16_t> &image, const std::vector<uint16_t> &previousImage, uint32_t width, uint32_t height, bool keyFrame, double maxBlockError, bool clusterFit) -> std::pair<std::vector<uint8_t>, std::vector<uint16_t>>
 {
     static_assert(sizeof(FrameHeader) % 4 == 0, "Size of frame header must be a multiple of 4 bytes");
     REQUIRE(width % CodeBook::BlockMaxDim == 0, std::runtime_error, "Image width must be a multiple of 16 for DXTV compression");
@@ -524,22 +822,33 @@ auto DXTV::encodeDXTV(const std::vector<uint16_t> &image, const std::vector<uint
             keyFrame = true;
         }
     }*/
+    // cluster-fit encode blocks of all sizes in parallel. some will not be used, because they are references or split
+    std::unique_ptr<EncodedBlocks> encodedBlocks;
+    if (clusterFit)
+    {
+        encodedBlocks = std::make_unique<EncodedBlocks>();
+        encodeAllBlocks<CodeBook::BlockMaxDim>(currentCodeBook, *encodedBlocks);
+        encodeAllBlocks<CodeBook::BlockMaxDim / 2>(currentCodeBook, *encodedBlocks);
+        encodeAllBlocks<CodeBook::BlockMaxDim / 4>(currentCodeBook, *encodedBlocks);
+    }
     // compress frame
     CompressionState state;
-    statistics = Statistics();
     // loop through source images blocks
     for (auto cbIt = currentCodeBook.begin<CodeBook::BlockMaxDim>(); cbIt != currentCodeBook.end<CodeBook::BlockMaxDim>(); ++cbIt)
     {
-        encodeBlock(currentCodeBook, previousCodeBook, *cbIt, state, maxBlockError);
+        encodeBlock(currentCodeBook, previousCodeBook, *cbIt, state, maxBlockError, encodedBlocks.get());
     }
-    // print statistics
+    // print statistics. build the line first, so lines of frames encoded in parallel don't get mixed up
+    const auto &statistics = state.statistics;
     const auto nrOfMinBlocks = width / CodeBook::BlockMinDim * height / CodeBook::BlockMinDim;
     double refPercentCurr = static_cast<double>((statistics.refBlocksCurr[0] * 16 + statistics.refBlocksCurr[1] * 4 + statistics.refBlocksCurr[2]) * 100) / nrOfMinBlocks;
     double refPercentPrev = static_cast<double>((statistics.refBlocksPrev[0] * 16 + statistics.refBlocksPrev[1] * 4 + statistics.refBlocksPrev[2]) * 100) / nrOfMinBlocks;
     double dxtPercent = static_cast<double>((statistics.dxtBlocks[0] * 16 + statistics.dxtBlocks[1] * 4 + statistics.dxtBlocks[2]) * 100) / nrOfMinBlocks;
-    std::cout << "Curr (16/8/4): " << statistics.refBlocksCurr[0] << "/" << statistics.refBlocksCurr[1] << "/" << statistics.refBlocksCurr[2] << " " << std::fixed << std::setprecision(1) << refPercentCurr << "%";
-    std::cout << ", Prev (16/8/4): " << statistics.refBlocksPrev[0] << "/" << statistics.refBlocksPrev[1] << "/" << statistics.refBlocksPrev[2] << " " << std::fixed << std::setprecision(1) << refPercentPrev << "%";
-    std::cout << ", DXT: " << statistics.dxtBlocks[0] << "/" << statistics.dxtBlocks[1] << "/" << statistics.dxtBlocks[2] << " " << std::fixed << std::setprecision(1) << dxtPercent << "%" << std::endl;
+    std::stringstream statisticsLine;
+    statisticsLine << "Curr (16/8/4): " << statistics.refBlocksCurr[0] << "/" << statistics.refBlocksCurr[1] << "/" << statistics.refBlocksCurr[2] << " " << std::fixed << std::setprecision(1) << refPercentCurr << "%";
+    statisticsLine << ", Prev (16/8/4): " << statistics.refBlocksPrev[0] << "/" << statistics.refBlocksPrev[1] << "/" << statistics.refBlocksPrev[2] << " " << std::fixed << std::setprecision(1) << refPercentPrev << "%";
+    statisticsLine << ", DXT: " << statistics.dxtBlocks[0] << "/" << statistics.dxtBlocks[1] << "/" << statistics.dxtBlocks[2] << " " << std::fixed << std::setprecision(1) << dxtPercent << "%" << std::endl;
+    std::cout << statisticsLine.str();
     //  add frame header to compressedData
     std::vector<uint8_t> compressedData;
     FrameHeader frameHeader;
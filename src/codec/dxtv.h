@@ -13,8 +13,9 @@ public:
     /// - Blocks are stored sequentially from left to right, top to bottom, but colors and indices are stored separately. First all colors, then all indices
     /// @param keyframe If true B-frame will be output, else a P-frame
     /// @param maxBlockError Max. allowed error for block references, if above a verbatim block will be stored. Range [0.1,1]
+    /// @param clusterFit If true use the slower, higher-quality cluster fit to find block endpoints, else range fit
     /// @return Returns (compressed data, decompressed frame)
-    static auto encodeDXTV(const std::vector<uint16_t> &image, const std::vector<uint16_t> &previousImage, uint32_t width, uint32_t height, bool keyFrame, double maxBlockError) -> std::pair<std::vector<uint8_t>, std::vector<uint16_t>>;
+    static auto encodeDXTV(const std::vector<uint16_t> &image, const std::vector<uint16_t> &previousImage, uint32_t width, uint32_t height, bool keyFrame, double maxBlockError, bool clusterFit = false) -> std::pair<std::vector<uint8_t>, std::vector<uint16_t>>;
 
     /// @brief Decompress from DXTV format
     static auto decodeDXTV(const std::vector<uint8_t> &data, uint32_t width, uint32_t height) -> std::vector<uint16_t>;
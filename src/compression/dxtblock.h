@@ -2,6 +2,7 @@
 
 #include "color/ycgcod.h"
 #include "color/colorhelpers.h"
+#include "compression/dxtclusterfit.h"
 #include "math/linefit.h"
 
 #include <Eigen/Core>
@@ -52,12 +53,18 @@ public:
 
     /// @brief DXT-encodes one NxM block
     /// This is basically the "range fit" method from here: http://www.sjbrown.co.uk/2006/01/19/dxt-compression-techniques/
-    static auto encode(const std::array<YCgCoRd, Width * Height> &colors) -> DXTBlock
+    /// @param clusterFit If true use the slower, higher-quality DXTClusterFit instead
+    static auto encode(const std::array<YCgCoRd, Width * Height> &colors, bool clusterFit = false) -> DXTBlock
     {
+        if (clusterFit)
+        {
+            const auto endpoints = DXTClusterFit<YCgCoRd, Width * Height>::encode(colors);
+            return {toBGR555(endpoints.color0), toBGR555(endpoints.color1), endpoints.indices};
+        }
         // calculate line fit through RGB color space
         auto originAndAxis = lineFit(colors);
         // calculate signed distance from origin
-        std::vector<double> distanceFromOrigin(Width * Height);
+        std::array<double, Width * Height> distanceFromOrigin;
         std::transform(colors.cbegin(), colors.cend(), distanceFromOrigin.begin(), [origin = originAndAxis.first, axis = originAndAxis.second](const auto &color)
                        { return color.dot(axis); });
         // get the distance of endpoints c0 and c1 on line
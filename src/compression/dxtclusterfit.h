@@ -0,0 +1,255 @@
+#pragma once
+
+#include "math/linefit.h"
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+
+/// @brief Result of a DXT endpoint search
+template <std::size_t N>
+struct DXTEndpoints
+{
+    uint16_t color0 = 0;            // Endpoint c0 as RGB555
+    uint16_t color1 = 0;            // Endpoint c1 as RGB555
+    std::array<uint8_t, N> indices; // Index of the closest endpoint / intermediate color for every color
+    double error = 0;               // Sum of color distances between the colors and the decoded block
+};
+
+/// @brief High-quality DXT endpoint search using the "cluster fit" method from here: http://www.sjbrown.co.uk/2006/01/19/dxt-compression-techniques/
+/// 1. Colors are sorted along their principal axis and all ways to split them into the 4 clusters c0, c2, c3, c1 are tried.
+///    For every split the endpoints are solved with least squares. For more than 16 colors split positions are searched in steps of N / 16.
+/// 2. The endpoints of the best split are rounded to the RGB555 grid and refined by alternating index assignment and least squares.
+/// 3. Endpoints are searched on the RGB555 grid by moving single components by +/-1 as long as the block error decreases.
+/// The block error is always measured with T::distance and the intermediate colors the decoder calculates.
+/// The result is never worse than the range fit endpoints
+/// @tparam T Color type. Must be derived from Eigen::Vector3d and provide fromRGB555, toRGB555, roundToRGB555 and distance
+/// @tparam N Number of colors in block
+template <typename T, std::size_t N>
+class DXTClusterFit
+{
+public:
+    static auto encode(const std::array<T, N> &colors) -> DXTEndpoints<N>
+    {
+        DXTEndpoints<N> best;
+        best.error = std::numeric_limits<double>::max();
+        auto tryEndpoints = [&colors, &best](uint16_t color0, uint16_t color1)
+        {
+            DXTEndpoints<N> candidate;
+            candidate.color0 = color0;
+            candidate.color1 = color1;
+            candidate.error = evaluate(colors, color0, color1, candidate.indices, best.error);
+            if (candidate.error < best.error)
+            {
+                best = candidate;
+                return true;
+            }
+            return false;
+        };
+        // sort colors along principal axis
+        const auto axis = lineFit(colors).second;
+        std::array<uint32_t, N> order;
+        std::iota(order.begin(), order.end(), 0);
+        std::array<double, N> distanceFromOrigin;
+        std::transform(colors.cbegin(), colors.cend(), distanceFromOrigin.begin(), [&axis](const auto &color)
+                       { return color.dot(axis); });
+        std::stable_sort(order.begin(), order.end(), [&distanceFromOrigin](auto a, auto b)
+                         { return distanceFromOrigin[a] < distanceFromOrigin[b]; });
+        // start with range fit endpoints
+        tryEndpoints(nearestRGB555(colors[order.front()]), nearestRGB555(colors[order.back()]));
+        if (best.error == 0)
+        {
+            return best;
+        }
+        // try splitting the sorted colors into clusters
+        if (const auto split = bestSplit(colors, order); split)
+        {
+            tryEndpoints(nearestRGB555(split->first), nearestRGB555(split->second));
+        }
+        // refine with least squares fit of current index assignment
+        for (uint32_t iteration = 0; iteration < MaxRefineIterations; iteration++)
+        {
+            const auto fit = leastSquares(colors, best.indices);
+            if (!fit || !tryEndpoints(nearestRGB555(fit->first), nearestRGB555(fit->second)))
+            {
+                break;
+            }
+        }
+        // search neighbouring RGB555 grid positions of endpoints
+        bool improved = true;
+        for (uint32_t pass = 0; improved && best.error > 0 && pass < MaxGridSearchPasses; pass++)
+        {
+            improved = false;
+            for (uint32_t shift = 0; shift <= 10; shift += 5)
+            {
+                for (int32_t delta : {-1, 1})
+                {
+                    const auto color0 = moveComponent(best.color0, shift, delta);
+                    if (color0 != best.color0)
+                    {
+                        improved = tryEndpoints(color0, best.color1) || improved;
+                    }
+                    const auto color1 = moveComponent(best.color1, shift, delta);
+                    if (color1 != best.color1)
+                    {
+                        improved = tryEndpoints(best.color0, color1) || improved;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    static constexpr uint32_t MaxRefineIterations = 8;
+    static constexpr uint32_t MaxGridSearchPasses = 32;
+    static constexpr std::array<double, 4> Weights0 = {1.0, 0.0, 2.0 / 3.0, 1.0 / 3.0}; // Weight of c0 in color of index 0-3
+    static constexpr std::array<double, 4> Weights1 = {0.0, 1.0, 1.0 / 3.0, 2.0 / 3.0}; // Weight of c1 in color of index 0-3
+
+    /// @brief Calculate block error and best indices for endpoints. Stops early and returns a value >= maxError when the error gets too big
+    static auto evaluate(const std::array<T, N> &colors, uint16_t color0, uint16_t color1, std::array<uint8_t, N> &indices, double maxError) -> double
+    {
+        // calculate intermediate colors c2 and c3 (rounded like in decoder)
+        const T c0 = T::fromRGB555(color0);
+        const T c1 = T::fromRGB555(color1);
+        const std::array<T, 4> endpoints = {c0, c1,
+                                            T::roundToRGB555(T((c0.cwiseProduct(T(2, 2, 2)) + c1).cwiseQuotient(T(3, 3, 3)))),
+                                            T::roundToRGB555(T((c0 + c1.cwiseProduct(T(2, 2, 2))).cwiseQuotient(T(3, 3, 3))))};
+        double error = 0;
+        for (std::size_t ci = 0; ci < N && error < maxError; ++ci)
+        {
+            double bestColorDistance = std::numeric_limits<double>::max();
+            for (uint32_t ei = 0; ei < 4; ++ei)
+            {
+                const auto indexDistance = T::distance(colors[ci], endpoints[ei]);
+                if (bestColorDistance > indexDistance)
+                {
+                    bestColorDistance = indexDistance;
+                    indices[ci] = static_cast<uint8_t>(ei);
+                }
+            }
+            error += bestColorDistance;
+        }
+        return error;
+    }
+
+    /// @brief Find the RGB555 color closest to a color
+    static auto nearestRGB555(const T &color) -> uint16_t
+    {
+        // truncated conversion can be off by one in any direction due to rounding errors, so check neighbours too
+        const auto truncated = color.toRGB555();
+        uint16_t bestColor = truncated;
+        double bestDistance = std::numeric_limits<double>::max();
+        for (int32_t dR = -1; dR <= 1; dR++)
+        {
+            for (int32_t dG = -1; dG <= 1; dG++)
+            {
+                for (int32_t dB = -1; dB <= 1; dB++)
+                {
+                    const auto candidate = moveComponent(moveComponent(moveComponent(truncated, 10, dR), 5, dG), 0, dB);
+                    const auto candidateDistance = T::distance(color, T::fromRGB555(candidate));
+                    if (bestDistance > candidateDistance)
+                    {
+                        bestDistance = candidateDistance;
+                        bestColor = candidate;
+                    }
+                }
+            }
+        }
+        return bestColor;
+    }
+
+    /// @brief Add delta to the 5-bit RGB555 component at shift and clamp it to [0,31]
+    static auto moveComponent(uint16_t color, uint32_t shift, int32_t delta) -> uint16_t
+    {
+        const int32_t component = std::clamp(static_cast<int32_t>((color >> shift) & 0x1F) + delta, 0, 31);
+        return static_cast<uint16_t>((color & ~(0x1F << shift)) | (component << shift));
+    }
+
+    /// @brief Solve endpoints c0 and c1 minimizing the squared error for colors with weights. Sums are sum(w0 * w0), sum(w0 * w1), sum(w1 * w1), sum(w0 * color), sum(w1 * color)
+    /// @return Returns (c0, c1) or nothing if the system has no unique solution
+    static auto solve(double w00, double w01, double w11, const Eigen::Vector3d &wc0, const Eigen::Vector3d &wc1) -> std::optional<std::pair<T, T>>
+    {
+        const double determinant = w00 * w11 - w01 * w01;
+        if (std::abs(determinant) < 1e-9)
+        {
+            return std::nullopt;
+        }
+        return std::make_pair(T(Eigen::Vector3d((w11 * wc0 - w01 * wc1) / determinant)), T(Eigen::Vector3d((w00 * wc1 - w01 * wc0) / determinant)));
+    }
+
+    /// @brief Least squares fit of endpoints for an index assignment
+    static auto leastSquares(const std::array<T, N> &colors, const std::array<uint8_t, N> &indices) -> std::optional<std::pair<T, T>>
+    {
+        double w00 = 0;
+        double w01 = 0;
+        double w11 = 0;
+        Eigen::Vector3d wc0 = Eigen::Vector3d::Zero();
+        Eigen::Vector3d wc1 = Eigen::Vector3d::Zero();
+        for (std::size_t ci = 0; ci < N; ++ci)
+        {
+            const auto w0 = Weights0[indices[ci]];
+            const auto w1 = Weights1[indices[ci]];
+            w00 += w0 * w0;
+            w01 += w0 * w1;
+            w11 += w1 * w1;
+            wc0 += w0 * colors[ci];
+            wc1 += w1 * colors[ci];
+        }
+        return solve(w00, w01, w11, wc0, wc1);
+    }
+
+    /// @brief Try all splits of the sorted colors into clusters c0, c2, c3, c1 and return the least squares endpoints of the split with the smallest error
+    static auto bestSplit(const std::array<T, N> &colors, const std::array<uint32_t, N> &order) -> std::optional<std::pair<T, T>>
+    {
+        constexpr std::size_t Step = N > 16 ? N / 16 : 1;
+        // prefix sums of sorted colors
+        std::array<Eigen::Vector3d, N + 1> sums;
+        sums[0] = Eigen::Vector3d::Zero();
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            sums[i + 1] = sums[i] + colors[order[i]];
+        }
+        // the squared error of a least squares solution is sum(color * color) - (c0 * wc0 + c1 * wc1), so maximize the second term
+        std::optional<std::pair<T, T>> best;
+        double bestGain = std::numeric_limits<double>::lowest();
+        for (std::size_t i = 0; i <= N; i += Step)
+        {
+            for (std::size_t j = i; j <= N; j += Step)
+            {
+                for (std::size_t k = j; k <= N; k += Step)
+                {
+                    const double n0 = static_cast<double>(i);
+                    const double n2 = static_cast<double>(j - i);
+                    const double n3 = static_cast<double>(k - j);
+                    const double n1 = static_cast<double>(N - k);
+                    const Eigen::Vector3d s0 = sums[i];
+                    const Eigen::Vector3d s2 = sums[j] - sums[i];
+                    const Eigen::Vector3d s3 = sums[k] - sums[j];
+                    const Eigen::Vector3d s1 = sums[N] - sums[k];
+                    const double w00 = n0 + n2 * (4.0 / 9.0) + n3 * (1.0 / 9.0);
+                    const double w01 = (n2 + n3) * (2.0 / 9.0);
+                    const double w11 = n1 + n2 * (1.0 / 9.0) + n3 * (4.0 / 9.0);
+                    const Eigen::Vector3d wc0 = s0 + s2 * (2.0 / 3.0) + s3 * (1.0 / 3.0);
+                    const Eigen::Vector3d wc1 = s1 + s2 * (1.0 / 3.0) + s3 * (2.0 / 3.0);
+                    if (const auto fit = solve(w00, w01, w11, wc0, wc1); fit)
+                    {
+                        const double gain = fit->first.dot(wc0) + fit->second.dot(wc1);
+                        if (gain > bestGain)
+                        {
+                            bestGain = gain;
+                            best = fit;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+};
@@ -0,0 +1,219 @@
+#include "huffman.h"
+
+#include "exception.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace Compression
+{
+
+    constexpr uint32_t HuffmanMaxNodeOffset = 63;
+
+    struct HuffmanNode
+    {
+        uint64_t frequency = 0;
+        int32_t children[2] = {-1, -1};
+        uint8_t symbol = 0;
+
+        auto isLeaf() const -> bool { return children[0] < 0; }
+    };
+
+    /// @brief Build Huffman tree from symbol frequencies. The root is the last node
+    static auto buildTree(const std::vector<uint64_t> &frequencies) -> std::vector<HuffmanNode>
+    {
+        std::vector<HuffmanNode> nodes;
+        for (uint32_t s = 0; s < frequencies.size(); s++)
+        {
+            if (frequencies[s] > 0)
+            {
+                HuffmanNode leaf;
+                leaf.frequency = frequencies[s];
+                leaf.symbol = static_cast<uint8_t>(s);
+                nodes.push_back(leaf);
+            }
+        }
+        // the tree needs at least two leaves. add an unused symbol if needed
+        for (uint32_t s = 0; nodes.size() < 2; s++)
+        {
+            if (frequencies[s] == 0)
+            {
+                HuffmanNode leaf;
+                leaf.symbol = static_cast<uint8_t>(s);
+                nodes.push_back(leaf);
+            }
+        }
+        // combine the two least frequent nodes until only the root is left. node index breaks ties, so the tree is deterministic
+        using QueueEntry = std::pair<uint64_t, int32_t>;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        for (int32_t i = 0; i < static_cast<int32_t>(nodes.size()); i++)
+        {
+            queue.push({nodes[i].frequency, i});
+        }
+        while (queue.size() > 1)
+        {
+            HuffmanNode node;
+            node.children[0] = queue.top().second;
+            queue.pop();
+            node.children[1] = queue.top().second;
+            queue.pop();
+            node.frequency = nodes[node.children[0]].frequency + nodes[node.children[1]].frequency;
+            nodes.push_back(node);
+            queue.push({node.frequency, static_cast<int32_t>(nodes.size() - 1)});
+        }
+        return nodes;
+    }
+
+    /// @brief Store tree in BIOS tree table format. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+    /// Child node pairs must be at most 63 pairs after their parent. Child pairs are placed depth-first to keep the number of
+    /// nodes waiting for their children low, unless this would make a waiting node miss its offset limit, then that node is placed first
+    /// @return Returns the table including the leading tree size byte or an empty vector if the tree can not be stored
+    static auto buildTreeTable(const std::vector<HuffmanNode> &nodes) -> std::vector<uint8_t>
+    {
+        const uint32_t nrOfLeaves = (nodes.size() + 1) / 2;
+        // tree size byte + 2 * nrOfLeaves - 1 nodes. must be padded so the bit stream starts at a multiple of 4
+        std::vector<uint8_t> table((2 * nrOfLeaves + 3) & ~3U, 0);
+        table[0] = static_cast<uint8_t>(table.size() / 2 - 1);
+        // nodes waiting for their children to be placed: node index and table address of node. the root is stored at address 1
+        std::vector<std::pair<int32_t, uint32_t>> pending = {{static_cast<int32_t>(nodes.size() - 1), 1}};
+        uint32_t nextPair = 1;
+        while (!pending.empty())
+        {
+            // check if placing the children of the last pending node still lets all other nodes meet their limit.
+            // pending nodes are sorted by address, so the first ones have the earliest limit
+            bool lastIsFeasible = true;
+            for (std::size_t i = 0; i + 1 < pending.size(); i++)
+            {
+                lastIsFeasible = lastIsFeasible && (pending[i].second / 2 + HuffmanMaxNodeOffset + 1) >= (nextPair + 1 + i);
+            }
+            const auto chosenIt = lastIsFeasible ? std::prev(pending.end()) : pending.begin();
+            const auto [nodeIndex, nodeAddress] = *chosenIt;
+            pending.erase(chosenIt);
+            const uint32_t offset = nextPair - nodeAddress / 2 - 1;
+            if (offset > HuffmanMaxNodeOffset)
+            {
+                return {};
+            }
+            // store node with offset to its children and flags for children that are leaves
+            const auto &node = nodes[nodeIndex];
+            table[nodeAddress] = static_cast<uint8_t>(offset);
+            for (uint32_t c = 0; c < 2; c++)
+            {
+                const auto &child = nodes[node.children[c]];
+                const auto childAddress = 2 * nextPair + c;
+                if (child.isLeaf())
+                {
+                    table[nodeAddress] |= 0x80 >> c;
+                    table[childAddress] = child.symbol;
+                }
+                else
+                {
+                    pending.push_back({node.children[c], childAddress});
+                }
+            }
+            nextPair++;
+        }
+        return table;
+    }
+
+    /// @brief Get code bits and length for all leaves
+    static auto buildCodes(const std::vector<HuffmanNode> &nodes, std::vector<std::pair<uint64_t, uint32_t>> &codes, int32_t nodeIndex, uint64_t code, uint32_t length) -> void
+    {
+        const auto &node = nodes[nodeIndex];
+        if (node.isLeaf())
+        {
+            REQUIRE(length <= 64, std::runtime_error, "Huffman code too long");
+            codes[node.symbol] = {code, length};
+        }
+        else
+        {
+            buildCodes(nodes, codes, node.children[0], code << 1, length + 1);
+            buildCodes(nodes, codes, node.children[1], (code << 1) | 1, length + 1);
+        }
+    }
+
+    std::vector<uint8_t> compressHuffman(const std::vector<uint8_t> &data, uint32_t bitsPerSymbol)
+    {
+        REQUIRE(data.size() < (1 << 24), std::runtime_error, "Data size must be < 16MB");
+        REQUIRE(bitsPerSymbol == 4 || bitsPerSymbol == 8, std::runtime_error, "Bits per symbol must be 4 or 8");
+        // split data into symbols
+        std::vector<uint8_t> symbols;
+        if (bitsPerSymbol == 4)
+        {
+            symbols.reserve(data.size() * 2);
+            for (auto b : data)
+            {
+                symbols.push_back(b & 0x0F);
+                symbols.push_back(b >> 4);
+            }
+        }
+        else
+        {
+            symbols = data;
+        }
+        std::vector<uint64_t> frequencies(1 << bitsPerSymbol, 0);
+        for (auto s : symbols)
+        {
+            frequencies[s]++;
+        }
+        // build tree. if it can not be stored due to the offset limit, flatten the symbol distribution and try again
+        std::vector<HuffmanNode> nodes;
+        std::vector<uint8_t> table;
+        while (true)
+        {
+            nodes = buildTree(frequencies);
+            table = buildTreeTable(nodes);
+            if (!table.empty())
+            {
+                break;
+            }
+            REQUIRE(std::any_of(frequencies.cbegin(), frequencies.cend(), [](auto f)
+                                { return f > 1; }),
+                    std::runtime_error, "Failed to build Huffman tree table");
+            std::for_each(frequencies.begin(), frequencies.end(), [](auto &f)
+                          { f = f > 0 ? (f >> 1) | 1 : 0; });
+        }
+        std::vector<std::pair<uint64_t, uint32_t>> codes(1 << bitsPerSymbol, {0, 0});
+        buildCodes(nodes, codes, static_cast<int32_t>(nodes.size() - 1), 0, 0);
+        // write BIOS header with type, symbol size and uncompressed size, then tree table
+        std::vector<uint8_t> result;
+        result.reserve(4 + table.size() + data.size() + 4);
+        const uint32_t header = (static_cast<uint32_t>(data.size()) << 8) | 0x20 | bitsPerSymbol;
+        result.push_back(header & 0xFF);
+        result.push_back((header >> 8) & 0xFF);
+        result.push_back((header >> 16) & 0xFF);
+        result.push_back((header >> 24) & 0xFF);
+        result.insert(result.end(), table.cbegin(), table.cend());
+        // write bit stream as little-endian 32-bit units, starting with bit 31
+        uint32_t word = 0;
+        uint32_t bitsInWord = 0;
+        auto writeWord = [&result](uint32_t w)
+        {
+            result.push_back(w & 0xFF);
+            result.push_back((w >> 8) & 0xFF);
+            result.push_back((w >> 16) & 0xFF);
+            result.push_back((w >> 24) & 0xFF);
+        };
+        for (auto s : symbols)
+        {
+            const auto [code, length] = codes[s];
+            for (uint32_t bit = length; bit-- > 0;)
+            {
+                word |= static_cast<uint32_t>((code >> bit) & 1) << (31 - bitsInWord);
+                if (++bitsInWord == 32)
+                {
+                    writeWord(word);
+                    word = 0;
+                    bitsInWord = 0;
+                }
+            }
+        }
+        if (bitsInWord > 0)
+        {
+            writeWord(word);
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Compression
+{
+
+    /// @brief Compress input data using GBA BIOS-compatible Huffman encoding and return the data.
+    /// Output starts with the BIOS header (type, symbol size and uncompressed size), followed by the tree table and the bit stream.
+    /// Output size is a multiple of 4 bytes. The data can be decompressed to WRAM or VRAM using HuffUnCompReadNormal
+    /// @param data Input data. Must be < 16MB
+    /// @param bitsPerSymbol Size of data symbols. Must be 4 or 8. 4-bit symbols are taken from the lower nibble of a byte first
+    std::vector<uint8_t> compressHuffman(const std::vector<uint8_t> &data, uint32_t bitsPerSymbol);
+
+}
@@ -0,0 +1,240 @@
+#include "lzinter.h"
+
+#include "exception.h"
+#include "lzssmatchfinder.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Compression
+{
+
+    constexpr uint32_t IntraMaxMatchLength = 0x12;
+    constexpr uint32_t IntraMaxDisplacement = 0x800;
+    constexpr uint32_t InterShortMaxMatchLength = 0x42;
+    constexpr uint32_t InterLongMaxMatchLength = 0x4042;
+    constexpr uint32_t InterMaxOffset = 0xFF;
+    constexpr uint32_t InterMaxCandidates = 64;
+
+    /// @brief Finds the longest match for a position in the current data in the previous data at the same or a higher position
+    class LzInterMatchFinder
+    {
+    public:
+        LzInterMatchFinder(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous)
+            : m_data(data), m_previous(previous), m_bucketStart((1 << LzssHashBits) + 1, 0)
+        {
+            // sort all positions in the previous data by hash using a counting sort. positions in a bucket stay in ascending order
+            const auto nrOfPositions = m_previous.size() >= LzssMinMatchLength ? m_previous.size() - LzssMinMatchLength + 1 : 0;
+            for (std::size_t i = 0; i < nrOfPositions; i++)
+            {
+                m_bucketStart[hash(m_previous.data() + i) + 1]++;
+            }
+            for (std::size_t h = 1; h < m_bucketStart.size(); h++)
+            {
+                m_bucketStart[h] += m_bucketStart[h - 1];
+            }
+            m_cursor.assign(m_bucketStart.cbegin(), m_bucketStart.cend() - 1);
+            m_positions.resize(nrOfPositions);
+            auto fill = m_cursor;
+            for (std::size_t i = 0; i < nrOfPositions; i++)
+            {
+                m_positions[fill[hash(m_previous.data() + i)]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        /// @brief Find longest match for position. Must be called with ascending positions. On equal length the smallest offset wins
+        /// @return Returns length and offset of match. Length is 0 if no match was found
+        auto find(uint32_t position) -> std::pair<uint32_t, uint32_t>
+        {
+            if (position + LzssMinMatchLength > m_data.size() || position + LzssMinMatchLength > m_previous.size())
+            {
+                return {0, 0};
+            }
+            const auto current = m_data.data() + position;
+            const auto maxLength = std::min(InterLongMaxMatchLength, static_cast<uint32_t>(m_data.size()) - position);
+            auto matchLength = [this, current, maxLength](uint32_t candidate)
+            {
+                const auto previous = m_previous.data() + candidate;
+                const auto length = std::min(maxLength, static_cast<uint32_t>(m_previous.size()) - candidate);
+                uint32_t i = 0;
+                while (i < length && previous[i] == current[i])
+                {
+                    i++;
+                }
+                return i;
+            };
+            // check unchanged data first. this is the most common case in video
+            uint32_t bestLength = matchLength(position);
+            uint32_t bestOffset = 0;
+            if (bestLength == maxLength)
+            {
+                return {bestLength, bestOffset};
+            }
+            // skip candidates before the current position. positions are ascending, so we never need to go back
+            const auto h = hash(current);
+            const auto bucketEnd = m_bucketStart[h + 1];
+            auto &cursor = m_cursor[h];
+            while (cursor < bucketEnd && m_positions[cursor] < position)
+            {
+                cursor++;
+            }
+            uint32_t nrOfCandidates = 0;
+            for (auto ci = cursor; ci < bucketEnd && nrOfCandidates < InterMaxCandidates; ci++, nrOfCandidates++)
+            {
+                const auto candidate = m_positions[ci];
+                if (candidate - position > InterMaxOffset)
+                {
+                    break;
+                }
+                if (candidate == position || candidate + bestLength >= m_previous.size() || m_previous[candidate + bestLength] != current[bestLength])
+                {
+                    continue;
+                }
+                const auto length = matchLength(candidate);
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestOffset = candidate - position;
+                    if (length == maxLength)
+                    {
+                        break;
+                    }
+                }
+            }
+            return {bestLength, bestOffset};
+        }
+
+    private:
+        static auto hash(const uint8_t *p) -> uint32_t
+        {
+            const uint32_t v = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+            return (v * 2654435761U) >> (32 - LzssHashBits);
+        }
+
+        const std::vector<uint8_t> &m_data;
+        const std::vector<uint8_t> &m_previous;
+        std::vector<uint32_t> m_bucketStart;
+        std::vector<uint32_t> m_cursor;
+        std::vector<uint32_t> m_positions;
+    };
+
+    std::vector<uint8_t> compressLzInter(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous)
+    {
+        REQUIRE(data.size() < (1 << 24), std::runtime_error, "Data size must be < 16MB");
+        LzssMatchFinder intraFinder(data, 1, IntraMaxDisplacement, IntraMaxMatchLength);
+        LzInterMatchFinder interFinder(data, previous);
+        std::vector<uint8_t> result;
+        result.reserve(4 + data.size() + (data.size() + 7) / 8);
+        // write BIOS-style header with type and uncompressed size
+        const uint32_t header = (static_cast<uint32_t>(data.size()) << 8) | LzInterTypeId;
+        result.push_back(header & 0xFF);
+        result.push_back((header >> 8) & 0xFF);
+        result.push_back((header >> 16) & 0xFF);
+        result.push_back((header >> 24) & 0xFF);
+        // greedily use the longest match. inter-frame matches win on equal length, because they are usually followed by more
+        uint32_t position = 0;
+        uint32_t tokenIndex = 0;
+        std::size_t flagIndex = 0;
+        while (position < data.size())
+        {
+            const auto bit = tokenIndex++ % 8;
+            if (bit == 0)
+            {
+                flagIndex = result.size();
+                result.push_back(0);
+            }
+            const auto [intraLength, displacement] = intraFinder.find(position);
+            const auto [interLength, offset] = interFinder.find(position);
+            uint32_t length = 1;
+            if (interLength >= LzssMinMatchLength && interLength >= intraLength)
+            {
+                length = interLength;
+                result[flagIndex] |= 0x80 >> bit;
+                if (length <= InterShortMaxMatchLength)
+                {
+                    result.push_back(static_cast<uint8_t>(0x80 | (length - 3)));
+                }
+                else
+                {
+                    const uint32_t l = length - (InterShortMaxMatchLength + 1);
+                    result.push_back(static_cast<uint8_t>(0xC0 | (l >> 8)));
+                    result.push_back(static_cast<uint8_t>(l & 0xFF));
+                }
+                result.push_back(static_cast<uint8_t>(offset));
+            }
+            else if (intraLength >= LzssMinMatchLength)
+            {
+                length = intraLength;
+                result[flagIndex] |= 0x80 >> bit;
+                const uint32_t d = displacement - 1;
+                result.push_back(static_cast<uint8_t>(((length - 3) << 3) | (d >> 8)));
+                result.push_back(static_cast<uint8_t>(d & 0xFF));
+            }
+            else
+            {
+                result.push_back(data[position]);
+            }
+            for (uint32_t i = 0; i < length; i++)
+            {
+                intraFinder.insert(position++);
+            }
+        }
+        // pad to multiple of 4 bytes
+        while (result.size() % 4 != 0)
+        {
+            result.push_back(0);
+        }
+        return result;
+    }
+
+    std::vector<uint8_t> decompressLzInter(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous)
+    {
+        REQUIRE(data.size() >= 4 && data[0] == LzInterTypeId, std::runtime_error, "Bad LZ inter-frame header");
+        const uint32_t size = static_cast<uint32_t>(data[1]) | (static_cast<uint32_t>(data[2]) << 8) | (static_cast<uint32_t>(data[3]) << 16);
+        // decompress in-place over the previous data like the GBA decoder does
+        auto result = previous;
+        result.resize(size);
+        std::size_t src = 4;
+        uint32_t position = 0;
+        auto nextByte = [&data, &src]()
+        {
+            REQUIRE(src < data.size(), std::runtime_error, "Unexpected end of LZ inter-frame data");
+            return data[src++];
+        };
+        while (position < size)
+        {
+            const auto flags = nextByte();
+            for (uint32_t bit = 0; bit < 8 && position < size; bit++)
+            {
+                if ((flags & (0x80 >> bit)) == 0)
+                {
+                    result[position++] = nextByte();
+                    continue;
+                }
+                const auto b0 = nextByte();
+                if ((b0 & 0x80) != 0)
+                {
+                    const uint32_t length = (b0 & 0x40) != 0 ? (((b0 & 0x3F) << 8) | nextByte()) + InterShortMaxMatchLength + 1 : (b0 & 0x3F) + 3;
+                    const uint32_t offset = nextByte();
+                    REQUIRE(position + offset + length <= previous.size() && position + length <= size, std::runtime_error, "Inter-frame match out of range");
+                    for (uint32_t i = 0; i < length; i++, position++)
+                    {
+                        result[position] = result[position + offset];
+                    }
+                }
+                else
+                {
+                    const uint32_t length = (b0 >> 3) + 3;
+                    const uint32_t displacement = (((b0 & 0x07) << 8) | nextByte()) + 1;
+                    REQUIRE(displacement <= position && position + length <= size, std::runtime_error, "Intra-frame match out of range");
+                    for (uint32_t i = 0; i < length; i++, position++)
+                    {
+                        result[position] = result[position - displacement];
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+}
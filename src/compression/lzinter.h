@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Compression
+{
+
+    /// @brief Type id stored in the lowest byte of the LZ inter-frame header
+    constexpr uint8_t LzInterTypeId = 0x12;
+
+    /// @brief Compress input data using LZ77 with matches into the current and the previous data and return the data.
+    /// Output starts with a BIOS-style header (type 0x12 and uncompressed size) and is padded to a multiple of 4 bytes.
+    /// Tokens are grouped by 8 behind a flag byte like LZ10, bit 7 is the first token. 1 = match, 0 = literal. Matches are:
+    /// - Intra-frame: 0LLLLDDD DDDDDDDD -> copy L + 3 bytes from D + 1 bytes before the current position
+    /// - Inter-frame: 10LLLLLL OOOOOOOO -> copy L + 3 bytes from the previous data at the current position + O
+    /// - Inter-frame: 11LLLLLL LLLLLLLL OOOOOOOO -> copy L + 67 bytes from the previous data at the current position + O
+    /// Inter-frame matches only read at or after the current position, so the data can be decompressed in-place over the previous data
+    /// @param data Input data. Must be < 16MB
+    /// @param previous Previous input data. Can be empty, then only intra-frame matches are used
+    std::vector<uint8_t> compressLzInter(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous);
+
+    /// @brief Decompress data compressed with compressLzInter. Reference implementation for verifying the output
+    /// @param data Compressed data including header
+    /// @param previous Previous uncompressed data the data was compressed against
+    std::vector<uint8_t> decompressLzInter(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous);
+
+}
@@ -1,112 +1,286 @@
 #include "lzss.h"
 
 #include "exception.h"
+#include "lzssmatchfinder.h"
 
-#ifdef _MSC_VER
-#include <process.h>
-#else
-#include <unistd.h>
-#endif
-
-#include <fstream>
-#include <filesystem>
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <omp.h>
+#include <utility>
 
 namespace Compression
 {
 
-    /// @brief Get environment variable from system.
-    std::string getEnv(const std::string &var)
+    constexpr uint32_t Lz10MaxMatchLength = 0x12;
+    constexpr uint32_t Lz11MaxMatchLength = 0x10110;
+    constexpr uint32_t LzssMaxDisplacement = 0x1000;
+
+    /// @brief Append match token to output. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+    static auto writeMatch(std::vector<uint8_t> &dst, uint32_t length, uint32_t displacement, bool lz11Compression) -> void
     {
-        const char *value = std::getenv(var.c_str());
-        return value != nullptr ? value : "";
+        const uint32_t d = displacement - 1;
+        if (!lz11Compression)
+        {
+            dst.push_back(static_cast<uint8_t>(((length - 3) << 4) | (d >> 8)));
+            dst.push_back(static_cast<uint8_t>(d & 0xFF));
+        }
+        else if (length <= 0x10)
+        {
+            dst.push_back(static_cast<uint8_t>(((length - 1) << 4) | (d >> 8)));
+            dst.push_back(static_cast<uint8_t>(d & 0xFF));
+        }
+        else if (length <= 0x110)
+        {
+            const uint32_t l = length - 0x11;
+            dst.push_back(static_cast<uint8_t>(l >> 4));
+            dst.push_back(static_cast<uint8_t>(((l & 0x0F) << 4) | (d >> 8)));
+            dst.push_back(static_cast<uint8_t>(d & 0xFF));
+        }
+        else
+        {
+            const uint32_t l = length - 0x111;
+            dst.push_back(static_cast<uint8_t>(0x10 | (l >> 12)));
+            dst.push_back(static_cast<uint8_t>((l >> 4) & 0xFF));
+            dst.push_back(static_cast<uint8_t>(((l & 0x0F) << 4) | (d >> 8)));
+            dst.push_back(static_cast<uint8_t>(d & 0xFF));
+        }
     }
 
-    static std::string GbaLzssPath;
+    /// @brief Literal or match. Literals have a length of 0
+    struct LzssToken
+    {
+        uint32_t length = 0;
+        uint32_t displacement = 0;
+    };
 
-    std::string findGbalzss()
+    /// @brief Split data into tokens, always using the longest match possible
+    static auto parseGreedy(const std::vector<uint8_t> &data, uint32_t minDisplacement, uint32_t maxLength) -> std::vector<LzssToken>
     {
-        std::string path;
-        std::string cmdLine;
-        auto dkpPath = getEnv("DEVKITPRO");
-        if (!dkpPath.empty())
-        {
-            // DevkitPro found. We assume the gbalzss executable is there...
-#ifdef WIN32
-            path = dkpPath + "\\tools\\bin\\gbalzss.exe";
-            cmdLine = path;
-#else
-            path = dkpPath + "/tools/bin/gbalzss";
-            cmdLine = path + " 2> /dev/null";
-#endif
-            // try to execute gbalzss and see if it works
-        }
-        else
+        std::vector<LzssToken> tokens;
+        LzssMatchFinder matchFinder(data, minDisplacement, LzssMaxDisplacement, maxLength);
+        uint32_t position = 0;
+        while (position < data.size())
         {
-            // DevkitPro not found. See if we can call gbalzss anyway
-#ifdef WIN32
-            path = "gbalzss.exe";
-            cmdLine = path;
-#else
-            path = "gbalzss";
-            cmdLine = path + " 2> /dev/null";
-#endif
-            // try to execute gbalzss and see if it works
+            const auto [length, displacement] = matchFinder.find(position);
+            if (length >= LzssMinMatchLength)
+            {
+                tokens.push_back({length, displacement});
+                for (uint32_t i = 0; i < length; i++)
+                {
+                    matchFinder.insert(position++);
+                }
+            }
+            else
+            {
+                tokens.push_back({});
+                matchFinder.insert(position++);
+            }
         }
-        return (WEXITSTATUS(system(cmdLine.c_str())) == 1 ? path : "");
+        return tokens;
     }
 
-    std::vector<uint8_t> compressLzss(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression)
+    /// @brief Split data into tokens so the output size is minimal. Finds the cheapest path through all literal and match choices
+    /// using dynamic programming from the end of the data. The size of a match only depends on its length, so the longest match
+    /// at a position can be cut to any shorter length
+    static auto parseOptimal(const std::vector<uint8_t> &data, uint32_t minDisplacement, uint32_t maxLength, bool lz11Compression) -> std::vector<LzssToken>
     {
-        if (GbaLzssPath.empty())
+        const auto size = static_cast<uint32_t>(data.size());
+        // find longest match for every position
+        std::vector<LzssToken> longest(size);
+        LzssMatchFinder matchFinder(data, minDisplacement, LzssMaxDisplacement, maxLength);
+        for (uint32_t position = 0; position < size; position++)
         {
-            GbaLzssPath = findGbalzss();
+            // the match of the previous position shortened by 1 is still valid here. start from it, else long runs are quadratic
+            const auto known = position > 0 && longest[position - 1].length > 1 ? longest[position - 1] : LzssToken{};
+            const auto [length, displacement] = matchFinder.find(position, known.length > 0 ? known.length - 1 : 0, known.displacement);
+            longest[position] = {length, displacement};
+            matchFinder.insert(position);
         }
-        REQUIRE(!GbaLzssPath.empty(), std::runtime_error, "No gbalzss executable found");
-        std::vector<uint8_t> result;
-// get process id
-#ifdef _MSC_VER
-        auto processId = _getpid();
-#else
-        auto processId = getpid();
-#endif
-        // write temporary file
-        const std::string tempFileName = std::filesystem::temp_directory_path().generic_string() + "/compress_" + std::to_string(processId) + ".tmp";
-        std::ofstream outFile(tempFileName, std::ios::binary | std::ios::out);
-        if (outFile.is_open())
-        {
-            outFile.write(reinterpret_cast<const char *>(data.data()), data.size());
-            outFile.close();
-            // run compressor
-            const std::string cmdLine = GbaLzssPath + (vramCompatible ? " --vram" : "") + (lz11Compression ? " --lz11" : "") + " e " + tempFileName + " " + tempFileName;
-            if (WEXITSTATUS(std::system(cmdLine.c_str())) == 0)
+        // token sizes in bits, including the flag bit. match sizes depend on the length range
+        struct LengthRange
+        {
+            uint32_t minLength;
+            uint32_t maxLength;
+            uint32_t bits;
+        };
+        const std::vector<LengthRange> lz10Ranges = {{3, Lz10MaxMatchLength, 17}};
+        const std::vector<LengthRange> lz11Ranges = {{3, 0x10, 17}, {0x11, 0x110, 25}, {0x111, Lz11MaxMatchLength, 33}};
+        const auto &lengthRanges = lz11Compression ? lz11Ranges : lz10Ranges;
+        constexpr uint32_t LiteralBits = 9;
+        // segment tree for the minimum cost in a range of positions. the key is the cost in the upper 32 bits
+        // and the inverted position in the lower 32 bits, so on equal cost the longer match is chosen
+        uint32_t leafCount = 1;
+        while (leafCount < size + 1)
+        {
+            leafCount <<= 1;
+        }
+        std::vector<uint64_t> tree(2 * leafCount, std::numeric_limits<uint64_t>::max());
+        auto setCost = [&tree, leafCount](uint32_t position, uint32_t cost)
+        {
+            auto node = leafCount + position;
+            tree[node] = (static_cast<uint64_t>(cost) << 32) | (0xFFFFFFFF - position);
+            for (node >>= 1; node > 0; node >>= 1)
+            {
+                tree[node] = std::min(tree[2 * node], tree[2 * node + 1]);
+            }
+        };
+        auto minCost = [&tree, leafCount](uint32_t first, uint32_t last)
+        {
+            uint64_t result = std::numeric_limits<uint64_t>::max();
+            for (auto l = first + leafCount, r = last + leafCount + 1; l < r; l >>= 1, r >>= 1)
             {
-                // read temporary file
-                std::ifstream inFile(tempFileName, std::ios::binary | std::ios::in);
-                if (inFile.is_open())
+                if (l & 1)
                 {
-                    // find file size
-                    inFile.seekg(0, std::ios::end);
-                    size_t fileSize = inFile.tellg();
-                    inFile.seekg(0, std::ios::beg);
-                    // read data
-                    result.resize(fileSize);
-                    inFile.read(reinterpret_cast<char *>(result.data()), fileSize);
-                    inFile.close();
+                    result = std::min(result, tree[l++]);
                 }
-                else
+                if (r & 1)
                 {
-                    THROW(std::runtime_error, "Failed to read temporary file");
+                    result = std::min(result, tree[--r]);
                 }
             }
+            return std::make_pair(static_cast<uint32_t>(result >> 32), 0xFFFFFFFF - static_cast<uint32_t>(result & 0xFFFFFFFF));
+        };
+        // find the cheapest token for every position, from the end of the data
+        std::vector<uint32_t> cost(size + 1, 0);
+        std::vector<uint32_t> choice(size, 0);
+        setCost(size, 0);
+        for (auto position = size; position-- > 0;)
+        {
+            uint32_t bestCost = LiteralBits + cost[position + 1];
+            uint32_t bestLength = 0;
+            const auto matchLength = longest[position].length;
+            for (const auto &range : lengthRanges)
+            {
+                if (matchLength < range.minLength)
+                {
+                    break;
+                }
+                const auto [rangeCost, nextPosition] = minCost(position + range.minLength, position + std::min(range.maxLength, matchLength));
+                if (range.bits + rangeCost < bestCost)
+                {
+                    bestCost = range.bits + rangeCost;
+                    bestLength = nextPosition - position;
+                }
+            }
+            cost[position] = bestCost;
+            choice[position] = bestLength;
+            setCost(position, bestCost);
+        }
+        // follow cheapest path from the start of the data
+        std::vector<LzssToken> tokens;
+        for (uint32_t position = 0; position < size;)
+        {
+            if (choice[position] >= LzssMinMatchLength)
+            {
+                tokens.push_back({choice[position], longest[position].displacement});
+                position += choice[position];
+            }
             else
             {
-                THROW(std::runtime_error, "Failed to run compressor");
+                tokens.push_back({});
+                position++;
+            }
+        }
+        return tokens;
+    }
+
+    std::vector<uint8_t> compressLzss(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression, bool optimalParse)
+    {
+        REQUIRE(data.size() < (1 << 24), std::runtime_error, "Data size must be < 16MB");
+        // VRAM can only be written in 16-bit units, so we can't copy from the byte we're just writing
+        const uint32_t minDisplacement = vramCompatible ? 2 : 1;
+        const uint32_t maxLength = lz11Compression ? Lz11MaxMatchLength : Lz10MaxMatchLength;
+        const auto tokens = optimalParse ? parseOptimal(data, minDisplacement, maxLength, lz11Compression) : parseGreedy(data, minDisplacement, maxLength);
+        std::vector<uint8_t> result;
+        result.reserve(4 + data.size() + (data.size() + 7) / 8);
+        // write BIOS header with type and uncompressed size
+        const uint32_t header = (static_cast<uint32_t>(data.size()) << 8) | (lz11Compression ? 0x11 : 0x10);
+        result.push_back(header & 0xFF);
+        result.push_back((header >> 8) & 0xFF);
+        result.push_back((header >> 16) & 0xFF);
+        result.push_back((header >> 24) & 0xFF);
+        // every block of 8 tokens is preceded by a flag byte. bit 7 is the first token. 1 = match, 0 = literal
+        uint32_t position = 0;
+        std::size_t flagIndex = 0;
+        for (std::size_t ti = 0; ti < tokens.size(); ti++)
+        {
+            const auto bit = ti % 8;
+            if (bit == 0)
+            {
+                flagIndex = result.size();
+                result.push_back(0);
+            }
+            const auto &token = tokens[ti];
+            if (token.length >= LzssMinMatchLength)
+            {
+                result[flagIndex] |= 0x80 >> bit;
+                writeMatch(result, token.length, token.displacement, lz11Compression);
+                position += token.length;
+            }
+            else
+            {
+                result.push_back(data[position++]);
+            }
+        }
+        // pad to multiple of 4 bytes
+        while (result.size() % 4 != 0)
+        {
+            result.push_back(0);
+        }
+        return result;
+    }
+
+    std::pair<std::vector<uint8_t>, std::vector<uint32_t>> compressLzssChunked(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression, bool optimalParse, uint32_t chunkSize)
+    {
+        REQUIRE(chunkSize > 0 && chunkSize % 4 == 0 && chunkSize < (1 << 24), std::runtime_error, "Chunk size must be a multiple of 4 and < 16MB");
+        const auto nrOfChunks = static_cast<int>((data.size() + chunkSize - 1) / chunkSize);
+        std::vector<std::vector<uint8_t>> chunks(nrOfChunks);
+        // exceptions must not escape the parallel region, so store them per chunk and rethrow the first one afterwards
+        std::vector<std::exception_ptr> errors(nrOfChunks);
+        auto compressChunk = [&](int ci)
+        {
+            try
+            {
+                const auto first = data.cbegin() + static_cast<std::size_t>(ci) * chunkSize;
+                const auto last = data.cbegin() + std::min(static_cast<std::size_t>(ci + 1) * chunkSize, data.size());
+                chunks[ci] = compressLzss(std::vector<uint8_t>(first, last), vramCompatible, lz11Compression, optimalParse);
+            }
+            catch (...)
+            {
+                errors[ci] = std::current_exception();
+            }
+        };
+        // we're usually called from a parallel loop over images. nested parallel regions would run serially there,
+        // so use tasks that the threads waiting at the end of the loop can pick up
+        if (omp_in_parallel())
+        {
+#pragma omp taskloop grainsize(1)
+            for (int ci = 0; ci < nrOfChunks; ci++)
+            {
+                compressChunk(ci);
             }
-            std::filesystem::remove(tempFileName);
         }
         else
         {
-            THROW(std::runtime_error, "Failed to write temporary file");
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int ci = 0; ci < nrOfChunks; ci++)
+            {
+                compressChunk(ci);
+            }
+        }
+        auto errorIt = std::find_if(errors.cbegin(), errors.cend(), [](const auto &e)
+                                    { return e != nullptr; });
+        if (errorIt != errors.cend())
+        {
+            std::rethrow_exception(*errorIt);
+        }
+        // concatenate chunks. all chunks are padded to 4 bytes, so all chunks stay aligned
+        std::pair<std::vector<uint8_t>, std::vector<uint32_t>> result;
+        for (const auto &chunk : chunks)
+        {
+            result.second.push_back(static_cast<uint32_t>(result.first.size()));
+            result.first.insert(result.first.end(), chunk.cbegin(), chunk.cend());
         }
         return result;
     }
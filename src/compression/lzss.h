@@ -1,17 +1,29 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
-#include <cstdint>
 
 namespace Compression
 {
 
-    /// @brief Find path to gbalzss executable
-    /// @return Path if found, empty string if not found
-    std::string findGbalzss();
+    /// @brief Compress input data using GBA BIOS-compatible LZ77 variant 10 or 11 and return the data.
+    /// Output starts with the BIOS header (type and uncompressed size) and is padded to a multiple of 4 bytes
+    /// @param data Input data. Must be < 16MB
+    /// @param vramCompatible If true no match will reference the byte directly before the current one, so data can be decompressed to VRAM using 16-bit writes
+    /// @param lz11Compression If true use variant 11 with longer matches, else variant 10
+    /// @param optimalParse If true choose literals and matches so the output is as small as possible. Slower than the default greedy longest-match parsing
+    std::vector<uint8_t> compressLzss(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression, bool optimalParse = false);
 
-    /// @brief Compress input data using lzss variant 10 or 11 and return the data
-    std::vector<uint8_t> compressLzss(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression);
+    /// @brief Split input data into chunks, compress them independently in parallel using compressLzss and concatenate them.
+    /// Every chunk is a complete LZ77 stream with BIOS header, so the chunks can be decompressed one by one
+    /// @param data Input data
+    /// @param vramCompatible See compressLzss
+    /// @param lz11Compression See compressLzss
+    /// @param optimalParse See compressLzss
+    /// @param chunkSize Uncompressed size of chunks. Must be a multiple of 4 and < 16MB. The last chunk may be smaller
+    /// @return Returns the compressed data and the byte offsets where the chunks start in it
+    std::pair<std::vector<uint8_t>, std::vector<uint32_t>> compressLzssChunked(const std::vector<uint8_t> &data, bool vramCompatible, bool lz11Compression, bool optimalParse, uint32_t chunkSize);
 
 }
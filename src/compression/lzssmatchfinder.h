@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Compression
+{
+
+    constexpr uint32_t LzssMinMatchLength = 3;
+    constexpr uint32_t LzssHashBits = 14;
+    constexpr uint32_t LzssMaxChainDepth = 1024;    // max. number of hash chain candidates checked per position
+    constexpr uint32_t LzssGoodMatchLength = 0x111; // stop searching when a match is at least this long. Longest LZ11 length class starts here
+
+    /// @brief Finds the longest match for a position in the data using hash chains of 3-byte sequences
+    class LzssMatchFinder
+    {
+    public:
+        LzssMatchFinder(const std::vector<uint8_t> &data, uint32_t minDisplacement, uint32_t maxDisplacement, uint32_t maxLength)
+            : m_data(data), m_minDisplacement(minDisplacement), m_maxDisplacement(maxDisplacement), m_maxLength(maxLength), m_head(1 << LzssHashBits, -1), m_previous(data.size(), -1)
+        {
+        }
+
+        /// @brief Add position to hash chains. Must be called for every position in ascending order
+        auto insert(uint32_t position) -> void
+        {
+            if (position + LzssMinMatchLength <= m_data.size())
+            {
+                auto &head = m_head[hash(position)];
+                m_previous[position] = head;
+                head = static_cast<int32_t>(position);
+            }
+        }
+
+        /// @brief Find longest match for position in previously inserted positions. On equal length the closest match wins.
+        /// Checks at most LzssMaxChainDepth candidates and stops at the first match of LzssGoodMatchLength or longer
+        /// @param knownLength Length of a match already known to exist at position, e.g. the match of the previous position shortened by 1. 0 if none
+        /// @param knownDisplacement Displacement of the known match. Must be within the allowed displacement range if knownLength > 0
+        /// @return Returns length and displacement of match. Length is 0 if no match was found
+        auto find(uint32_t position, uint32_t knownLength = 0, uint32_t knownDisplacement = 0) const -> std::pair<uint32_t, uint32_t>
+        {
+            uint32_t bestLength = 0;
+            uint32_t bestDisplacement = 0;
+            if (position + LzssMinMatchLength > m_data.size())
+            {
+                return {bestLength, bestDisplacement};
+            }
+            const uint32_t maxLength = std::min(m_maxLength, static_cast<uint32_t>(m_data.size()) - position);
+            const auto current = m_data.data() + position;
+            if (knownLength > 0)
+            {
+                // extend known match, so runs don't get compared from their start again for every position
+                const auto previous = current - knownDisplacement;
+                bestLength = std::min(knownLength, maxLength);
+                while (bestLength < maxLength && previous[bestLength] == current[bestLength])
+                {
+                    bestLength++;
+                }
+                bestDisplacement = knownDisplacement;
+                if (bestLength >= std::min(LzssGoodMatchLength, maxLength))
+                {
+                    return {bestLength, bestDisplacement};
+                }
+            }
+            uint32_t depth = 0;
+            for (auto candidate = m_head[hash(position)]; candidate >= 0 && depth < LzssMaxChainDepth; candidate = m_previous[candidate], depth++)
+            {
+                const uint32_t displacement = position - static_cast<uint32_t>(candidate);
+                if (displacement > m_maxDisplacement)
+                {
+                    // chains are sorted by position, so all following candidates are too far away
+                    break;
+                }
+                if (displacement < m_minDisplacement || displacement == knownDisplacement)
+                {
+                    continue;
+                }
+                // check byte after current best length first to skip candidates that can't be longer
+                const auto previous = m_data.data() + candidate;
+                if (bestLength > 0 && previous[bestLength] != current[bestLength])
+                {
+                    continue;
+                }
+                uint32_t length = 0;
+                while (length < maxLength && previous[length] == current[length])
+                {
+                    length++;
+                }
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDisplacement = displacement;
+                    if (length >= std::min(LzssGoodMatchLength, maxLength))
+                    {
+                        break;
+                    }
+                }
+            }
+            return {bestLength, bestDisplacement};
+        }
+
+    private:
+        auto hash(uint32_t position) const -> uint32_t
+        {
+            const uint32_t v = (static_cast<uint32_t>(m_data[position]) << 16) | (static_cast<uint32_t>(m_data[position + 1]) << 8) | m_data[position + 2];
+            return (v * 2654435761U) >> (32 - LzssHashBits);
+        }
+
+        const std::vector<uint8_t> &m_data;
+        const uint32_t m_minDisplacement;
+        const uint32_t m_maxDisplacement;
+        const uint32_t m_maxLength;
+        std::vector<int32_t> m_head;
+        std::vector<int32_t> m_previous;
+    };
+
+}
@@ -0,0 +1,200 @@
+#include "rans.h"
+
+#include "exception.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Compression
+{
+
+    constexpr uint32_t RansTotal = 1 << RansScaleBits;
+    constexpr uint32_t RansLowerBound = 1 << 16;
+
+    /// @brief Scale symbol counts so they sum up to RansTotal. Every symbol that occurs gets a frequency >= 1.
+    /// Rounding errors are distributed to the symbols where they increase the encoded size the least
+    static auto normalizeFrequencies(const std::array<uint32_t, 256> &counts, uint32_t nrOfSymbols) -> std::array<uint32_t, 256>
+    {
+        std::array<uint32_t, 256> frequencies = {};
+        uint32_t sum = 0;
+        for (uint32_t s = 0; s < 256; s++)
+        {
+            if (counts[s] > 0)
+            {
+                frequencies[s] = std::max(uint32_t(1), static_cast<uint32_t>(std::round(static_cast<double>(counts[s]) * RansTotal / nrOfSymbols)));
+                sum += frequencies[s];
+            }
+        }
+        while (sum != RansTotal)
+        {
+            // find the symbol where changing the frequency by one costs the least bits
+            const bool decrease = sum > RansTotal;
+            int32_t bestSymbol = -1;
+            double bestCost = 0;
+            for (uint32_t s = 0; s < 256; s++)
+            {
+                if (counts[s] == 0 || (decrease && frequencies[s] <= 1))
+                {
+                    continue;
+                }
+                const double f = frequencies[s];
+                const double cost = decrease ? counts[s] * std::log2(f / (f - 1)) : -(counts[s] * std::log2((f + 1) / f));
+                if (bestSymbol < 0 || cost < bestCost)
+                {
+                    bestSymbol = static_cast<int32_t>(s);
+                    bestCost = cost;
+                }
+            }
+            frequencies[bestSymbol] += decrease ? -1 : 1;
+            sum += decrease ? -1 : 1;
+        }
+        return frequencies;
+    }
+
+    std::vector<uint8_t> compressRans(const std::vector<uint8_t> &data)
+    {
+        REQUIRE(data.size() < (1 << 24), std::runtime_error, "Data size must be < 16MB");
+        std::vector<uint8_t> result;
+        result.reserve(4 + 512 + 4 + data.size() + data.size() / 8);
+        // write BIOS-style header with type and uncompressed size
+        const uint32_t header = (static_cast<uint32_t>(data.size()) << 8) | RansTypeId;
+        result.push_back(header & 0xFF);
+        result.push_back((header >> 8) & 0xFF);
+        result.push_back((header >> 16) & 0xFF);
+        result.push_back((header >> 24) & 0xFF);
+        // build frequency table
+        std::array<uint32_t, 256> counts = {};
+        for (auto v : data)
+        {
+            counts[v]++;
+        }
+        std::array<uint32_t, 256> frequencies = {};
+        std::array<uint32_t, 256> starts = {};
+        if (!data.empty())
+        {
+            frequencies = normalizeFrequencies(counts, static_cast<uint32_t>(data.size()));
+            for (uint32_t s = 1; s < 256; s++)
+            {
+                starts[s] = starts[s - 1] + frequencies[s - 1];
+            }
+        }
+        // store frequency table with runs of unused symbols
+        for (uint32_t s = 0; s < 256;)
+        {
+            if (frequencies[s] == 0)
+            {
+                uint32_t run = 1;
+                while (s + run < 256 && frequencies[s + run] == 0)
+                {
+                    run++;
+                }
+                result.push_back(0);
+                result.push_back(static_cast<uint8_t>(run - 1));
+                s += run;
+            }
+            else
+            {
+                if (frequencies[s] < 0x80)
+                {
+                    result.push_back(static_cast<uint8_t>(frequencies[s]));
+                }
+                else
+                {
+                    result.push_back(static_cast<uint8_t>(0x80 | (frequencies[s] >> 8)));
+                    result.push_back(static_cast<uint8_t>(frequencies[s] & 0xFF));
+                }
+                s++;
+            }
+        }
+        while (result.size() % 4 != 0)
+        {
+            result.push_back(0);
+        }
+        // encode symbols in reverse, so the decoder can read them forward
+        std::vector<uint16_t> words;
+        words.reserve(data.size() / 2);
+        uint32_t state = RansLowerBound;
+        for (auto it = data.crbegin(); it != data.crend(); ++it)
+        {
+            const auto frequency = frequencies[*it];
+            const uint64_t maxState = (static_cast<uint64_t>(RansLowerBound >> RansScaleBits) << 16) * frequency;
+            if (state >= maxState)
+            {
+                words.push_back(static_cast<uint16_t>(state & 0xFFFF));
+                state >>= 16;
+            }
+            state = ((state / frequency) << RansScaleBits) + (state % frequency) + starts[*it];
+        }
+        result.push_back(state & 0xFF);
+        result.push_back((state >> 8) & 0xFF);
+        result.push_back((state >> 16) & 0xFF);
+        result.push_back((state >> 24) & 0xFF);
+        for (auto it = words.crbegin(); it != words.crend(); ++it)
+        {
+            result.push_back(*it & 0xFF);
+            result.push_back(*it >> 8);
+        }
+        // pad to multiple of 4 bytes
+        while (result.size() % 4 != 0)
+        {
+            result.push_back(0);
+        }
+        return result;
+    }
+
+    std::vector<uint8_t> decompressRans(const std::vector<uint8_t> &data)
+    {
+        REQUIRE(data.size() >= 4 && data[0] == RansTypeId, std::runtime_error, "Bad rANS header");
+        const uint32_t size = static_cast<uint32_t>(data[1]) | (static_cast<uint32_t>(data[2]) << 8) | (static_cast<uint32_t>(data[3]) << 16);
+        std::size_t src = 4;
+        auto nextByte = [&data, &src]()
+        {
+            REQUIRE(src < data.size(), std::runtime_error, "Unexpected end of rANS data");
+            return data[src++];
+        };
+        // read frequency table and build slot -> symbol table
+        std::array<uint32_t, 256> frequencies = {};
+        std::array<uint32_t, 256> starts = {};
+        std::vector<uint8_t> symbols(RansTotal, 0);
+        uint32_t sum = 0;
+        for (uint32_t s = 0; s < 256;)
+        {
+            const uint32_t b = nextByte();
+            if (b == 0)
+            {
+                s += nextByte() + 1;
+                continue;
+            }
+            frequencies[s] = (b & 0x80) != 0 ? (((b & 0x7F) << 8) | nextByte()) : b;
+            starts[s] = sum;
+            REQUIRE(sum + frequencies[s] <= RansTotal, std::runtime_error, "Bad rANS frequency table");
+            std::fill(symbols.begin() + sum, symbols.begin() + sum + frequencies[s], static_cast<uint8_t>(s));
+            sum += frequencies[s];
+            s++;
+        }
+        REQUIRE(size == 0 || sum == RansTotal, std::runtime_error, "Bad rANS frequency table");
+        src = (src + 3) & ~std::size_t(3);
+        uint32_t state = nextByte();
+        state |= static_cast<uint32_t>(nextByte()) << 8;
+        state |= static_cast<uint32_t>(nextByte()) << 16;
+        state |= static_cast<uint32_t>(nextByte()) << 24;
+        // decode symbols
+        std::vector<uint8_t> result(size);
+        for (uint32_t i = 0; i < size; i++)
+        {
+            const auto slot = state & (RansTotal - 1);
+            const auto symbol = symbols[slot];
+            result[i] = symbol;
+            state = frequencies[symbol] * (state >> RansScaleBits) + slot - starts[symbol];
+            if (state < RansLowerBound)
+            {
+                state = (state << 16) | nextByte();
+                state |= static_cast<uint32_t>(nextByte()) << 8;
+            }
+        }
+        REQUIRE(state == RansLowerBound, std::runtime_error, "Bad rANS final state");
+        return result;
+    }
+
+}
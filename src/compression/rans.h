@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Compression
+{
+
+    /// @brief Type id stored in the lowest byte of the rANS header
+    constexpr uint8_t RansTypeId = 0x40;
+
+    /// @brief Symbol probabilities are quantized to this many bits. The decoder needs a table of 1 << RansScaleBits bytes
+    constexpr uint32_t RansScaleBits = 12;
+
+    /// @brief Compress input data using a byte-wise rANS entropy coder with a 32-bit state and 16-bit renormalization and return the data.
+    /// Output is laid out as:
+    /// - Header: (uncompressed size << 8) | 0x40
+    /// - Frequency table for symbols 0-255. Frequencies sum up to 1 << RansScaleBits. Every entry is:
+    ///   0x00 N = N + 1 symbols with frequency 0, 0x01-0x7F = frequency, 0x8H LL = frequency 0xHLL. Padded to a multiple of 4 bytes
+    /// - Initial 32-bit decoder state
+    /// - 16-bit renormalization words in decoding order. Padded to a multiple of 4 bytes
+    /// @param data Input data. Must be < 16MB
+    std::vector<uint8_t> compressRans(const std::vector<uint8_t> &data);
+
+    /// @brief Decompress data compressed with compressRans. Reference implementation for verifying the output
+    std::vector<uint8_t> decompressRans(const std::vector<uint8_t> &data);
+
+}
@@ -0,0 +1,67 @@
+#include "rle.h"
+
+#include "exception.h"
+
+#include <algorithm>
+
+namespace Compression
+{
+
+    constexpr uint32_t RleMinRunLength = 3;
+    constexpr uint32_t RleMaxRunLength = 0x82;
+    constexpr uint32_t RleMaxLiteralLength = 0x80;
+
+    /// @brief Append literal blocks for data [first, last) to output. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+    static auto writeLiterals(std::vector<uint8_t> &dst, const std::vector<uint8_t> &data, std::size_t first, std::size_t last) -> void
+    {
+        while (first < last)
+        {
+            const auto length = std::min(last - first, static_cast<std::size_t>(RleMaxLiteralLength));
+            dst.push_back(static_cast<uint8_t>(length - 1));
+            dst.insert(dst.end(), std::next(data.cbegin(), first), std::next(data.cbegin(), first + length));
+            first += length;
+        }
+    }
+
+    std::vector<uint8_t> compressRle(const std::vector<uint8_t> &data, bool vramCompatible)
+    {
+        REQUIRE(data.size() < (1 << 24), std::runtime_error, "Data size must be < 16MB");
+        REQUIRE(!vramCompatible || (data.size() % 2) == 0, std::runtime_error, "Data size must be a multiple of 2 for VRAM-compatible RLE");
+        std::vector<uint8_t> result;
+        result.reserve(4 + data.size() + (data.size() + RleMaxLiteralLength - 1) / RleMaxLiteralLength);
+        // write BIOS header with type and uncompressed size
+        const uint32_t header = (static_cast<uint32_t>(data.size()) << 8) | 0x30;
+        result.push_back(header & 0xFF);
+        result.push_back((header >> 8) & 0xFF);
+        result.push_back((header >> 16) & 0xFF);
+        result.push_back((header >> 24) & 0xFF);
+        // collect literals until we find a run that is long enough to be stored as a compressed block
+        std::size_t literalStart = 0;
+        std::size_t position = 0;
+        while (position < data.size())
+        {
+            const auto maxLength = std::min(data.size() - position, static_cast<std::size_t>(RleMaxRunLength));
+            std::size_t length = 1;
+            while (length < maxLength && data[position + length] == data[position])
+            {
+                length++;
+            }
+            if (length >= RleMinRunLength)
+            {
+                writeLiterals(result, data, literalStart, position);
+                result.push_back(static_cast<uint8_t>(0x80 | (length - RleMinRunLength)));
+                result.push_back(data[position]);
+                literalStart = position + length;
+            }
+            position += length;
+        }
+        writeLiterals(result, data, literalStart, data.size());
+        // pad to multiple of 4 bytes
+        while (result.size() % 4 != 0)
+        {
+            result.push_back(0);
+        }
+        return result;
+    }
+
+}
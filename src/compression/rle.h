@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Compression
+{
+
+    /// @brief Compress input data using GBA BIOS-compatible run-length encoding and return the data.
+    /// Output starts with the BIOS header (type and uncompressed size) and is padded to a multiple of 4 bytes
+    /// @param data Input data. Must be < 16MB
+    /// @param vramCompatible If true the data can be decompressed to VRAM with RLUnCompReadNormalWrite16bit. The BIOS collects bytes
+    /// into 16-bit units itself, so the stream is the same, but the data size must be a multiple of 2
+    std::vector<uint8_t> compressRle(const std::vector<uint8_t> &data, bool vramCompatible);
+
+}
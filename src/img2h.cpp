@@ -7,12 +7,16 @@
 #include "processing/imageprocessing.h"
 #include "processing/processingoptions.h"
 #include "processing/spritehelpers.h"
+#include "statistics/statistics.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <filesystem>
 
@@ -57,10 +61,13 @@ bool readArguments(int argc, const char *argv[])
         opts.add_option("", options.tilemap.cxxOption);
         opts.add_option("", options.delta8.cxxOption);
         opts.add_option("", options.delta16.cxxOption);
-        // opts.add_option("", options.rle.cxxOption);
+        opts.add_option("", options.rle.cxxOption);
+        opts.add_option("", options.huffman.cxxOption);
         opts.add_option("", options.lz10.cxxOption);
         opts.add_option("", options.lz11.cxxOption);
         opts.add_option("", options.vram.cxxOption);
+        opts.add_option("", options.lzOptimal.cxxOption);
+        opts.add_option("", options.lzChunk.cxxOption);
         opts.add_option("", options.interleavePixels.cxxOption);
         opts.add_option("", {"positional", "", cxxopts::value<std::vector<std::string>>()});
         opts.parse_positional({"infile", "outname", "positional"});
@@ -111,6 +118,23 @@ bool readArguments(int argc, const char *argv[])
             std::cerr << "Only a single LZ-compression option is allowed." << std::endl;
             return false;
         }
+        options.huffman.parse(result);
+        if (options.huffman && (options.lz10 || options.lz11))
+        {
+            std::cerr << "Huffman compression can not be combined with LZ-compression." << std::endl;
+            return false;
+        }
+        options.lzChunk.parse(result);
+        if (options.lzChunk && !(options.lz10 || options.lz11))
+        {
+            std::cerr << "Chunked compression needs LZ-compression." << std::endl;
+            return false;
+        }
+        if (options.lzChunk && options.interleavePixels)
+        {
+            std::cerr << "Chunked compression can not be combined with pixel interleaving." << std::endl;
+            return false;
+        }
         options.addColor0.parse(result);
         options.moveColor0.parse(result);
         options.shiftIndices.parse(result);
@@ -152,13 +176,15 @@ void printUsage()
     std::cout << options.delta16.helpString() << std::endl;
     std::cout << options.interleavePixels.helpString() << std::endl;
     std::cout << "COMPRESSION options (mutually exclusive):" << std::endl;
-    // std::cout << options.rle.helpString() << std::endl;
+    std::cout << options.rle.helpString() << std::endl;
+    std::cout << options.huffman.helpString() << std::endl;
     std::cout << options.lz10.helpString() << std::endl;
     std::cout << options.lz11.helpString() << std::endl;
     std::cout << "COMPRESSION modifiers (optional):" << std::endl;
     std::cout << options.vram.helpString() << std::endl;
+    std::cout << options.lzOptimal.helpString() << std::endl;
+    std::cout << options.lzChunk.helpString() << std::endl;
     std::cout << "Valid combinations are e.g. \"--rle --lz10\" or \"--lz11 --vram\"." << std::endl;
-    std::cout << "You must have DevkitPro installed or the gbalzss executable must be in PATH." << std::endl;
     std::cout << "INFILE: can be a file list and/or can have * as a wildcard. Multiple input " << std::endl;
     std::cout << "images MUST have the same type (palette / true color) and resolution!" << std::endl;
     std::cout << "OUTNAME: is determined from the first non-existant file path. It can be an " << std::endl;
@@ -166,7 +192,7 @@ void printUsage()
     std::cout << "OUTNAME.c will be generated. All variables will begin with the base name " << std::endl;
     std::cout << "portion of OUTNAME." << std::endl;
     std::cout << "ORDER: input, reordercolors, addcolor0, movecolor0, shift, prune, sprites" << std::endl;
-    std::cout << "tiles, tilemap, delta8 / delta16, rle, lz10 / lz11, interleavepixels, output" << std::endl;
+    std::cout << "tiles, tilemap, delta8 / delta16, rle, huffman, lz10 / lz11, interleavepixels, output" << std::endl;
 }
 
 std::tuple<bool, Magick::Geometry, std::vector<Image::Data>> readImages(const std::vector<std::string> &fileNames, const ProcessingOptions &options)
@@ -275,6 +301,9 @@ int main(int argc, const char *argv[])
         auto [imgIsPaletted, imgSize, images] = readImages(m_inFile, options);
         // build processing pipeline
         Image::Processing processing;
+        // collect step run times
+        auto statistics = std::make_shared<Statistics::Container>();
+        processing.setStatisticsContainer(statistics);
         if (options.reorderColors)
         {
             processing.addStep(Image::ProcessingType::ReorderColors, {});
@@ -324,23 +353,28 @@ int main(int argc, const char *argv[])
         {
             processing.addStep(Image::ProcessingType::ConvertDelta16, {});
         }
-        /*if (options.rle)
+        if (options.rle)
+        {
+            processing.addStep(Image::ProcessingType::CompressRLE, {options.vram.isSet});
+        }
+        if (options.huffman)
         {
-            processing.addStep(Image::ProcessingType::CompressRLE, {});
-        }*/
+            processing.addStep(Image::ProcessingType::CompressHuffman, {options.huffman.value});
+        }
         if (options.lz10)
         {
-            processing.addStep(Image::ProcessingType::CompressLz10, {options.vram.isSet});
+            processing.addStep(Image::ProcessingType::CompressLz10, {options.vram.isSet, options.lzOptimal.isSet, options.lzChunk.value});
         }
         if (options.lz11)
         {
-            processing.addStep(Image::ProcessingType::CompressLz11, {options.vram.isSet});
+            processing.addStep(Image::ProcessingType::CompressLz11, {options.vram.isSet, options.lzOptimal.isSet, options.lzChunk.value});
         }
         processing.addStep(Image::ProcessingType::PadImageData, {uint32_t(4)}, {});
         // apply image processing pipeline
         const auto processingDescription = processing.getProcessingDescription();
         std::cout << "Applying processing: " << processingDescription << (options.interleavePixels ? ", interleave pixels" : "") << std::endl;
         images = processing.processBatch(images);
+        statistics->printTimings(std::cout);
         // check if all color maps are the same
         bool allColorMapsSame = true;
         uint32_t maxColorMapColors = 0;
@@ -428,6 +462,21 @@ int main(int argc, const char *argv[])
                     writeImageInfoToH(hFile, varName, imageData32, {}, imgSize.width(), imgSize.height(), nrOfBytesPerImageOrSprite, nrOfImagesOrSprites, storeTileOrSpriteWise);
                     writeImageDataToC(cFile, varName, baseName, imageData32, imageOrSpriteStartIndices, {}, storeTileOrSpriteWise);
                 }
+                if (options.lzChunk)
+                {
+                    // convert chunk offsets to indices into the combined image data
+                    std::vector<uint32_t> chunkStartIndices;
+                    std::vector<uint32_t> chunksPerImage;
+                    for (std::size_t i = 0; i < images.size(); i++)
+                    {
+                        const uint32_t imageStartIndex = imageOrSpriteStartIndices.size() > i ? imageOrSpriteStartIndices[i] : 0;
+                        std::transform(images[i].compressedChunkOffsets.cbegin(), images[i].compressedChunkOffsets.cend(), std::back_inserter(chunkStartIndices), [imageStartIndex](auto offset)
+                                       { return imageStartIndex + offset / 4; });
+                        chunksPerImage.push_back(static_cast<uint32_t>(images[i].compressedChunkOffsets.size()));
+                    }
+                    writeChunkInfoToH(hFile, varName, options.lzChunk.value, chunkStartIndices.size(), images.size());
+                    writeChunkDataToC(cFile, varName, chunkStartIndices, chunksPerImage);
+                }
                 if (imgIsPaletted)
                 {
                     auto [paletteData16, colorMapsStartIndices] = (allColorMapsSame ? std::make_pair(convertToBGR555(images.front().colorMap), std::vector<uint32_t>()) : Image::Processing::combineColorMaps<uint16_t>(images, [](auto cm)
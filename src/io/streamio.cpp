@@ -1,5 +1,8 @@
 #include "streamio.h"
 
+#include <cstddef>
+#include <ostream>
+
 namespace Image
 {
 
@@ -30,22 +33,76 @@ namespace Image
     }
 
     auto IO::writeFileHeader(std::ostream &os, const std::vector<Data> &frames, uint8_t fps, uint32_t maxMemoryNeeded) -> std::ostream &
+    {
+        return writeFileHeader(os, frames.front(), frames.size(), fps, maxMemoryNeeded);
+    }
+
+    auto IO::writeFileHeader(std::ostream &os, const Data &firstFrame, uint32_t nrOfFrames, uint8_t fps, uint32_t maxMemoryNeeded) -> std::ostream &
     {
         REQUIRE((sizeof(FileHeader) & 3) == 0, std::runtime_error, "FileHeader size is not a multiple of 4");
         // check if we're using a color map
-        const bool frameHasColorMap = hasColorMap(frames.front());
+        const bool frameHasColorMap = hasColorMap(firstFrame);
         // generate file header and store it
         FileHeader fileHeader;
-        fileHeader.nrOfFrames = frames.size();
-        fileHeader.width = frames.front().size.width();
-        fileHeader.height = frames.front().size.height();
+        fileHeader.nrOfFrames = nrOfFrames;
+        fileHeader.width = firstFrame.size.width();
+        fileHeader.height = firstFrame.size.height();
         fileHeader.fps = fps;
-        fileHeader.bitsPerPixel = bitsPerPixelForFormat(frames.front().colorFormat);
-        fileHeader.bitsPerColor = frameHasColorMap ? bitsPerPixelForFormat(frames.front().colorMapFormat) : 0;
-        fileHeader.colorMapEntries = frameHasColorMap ? frames.front().colorMap.size() : 0;
+        fileHeader.bitsPerPixel = bitsPerPixelForFormat(firstFrame.colorFormat);
+        fileHeader.bitsPerColor = frameHasColorMap ? bitsPerPixelForFormat(firstFrame.colorMapFormat) : 0;
+        fileHeader.colorMapEntries = frameHasColorMap ? firstFrame.colorMap.size() : 0;
         fileHeader.maxMemoryNeeded = maxMemoryNeeded;
         os.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
         return os;
     }
 
+    IO::StreamWriter::StreamWriter(std::ostream &os, uint8_t fps)
+        : m_os(os), m_headerPosition(os.tellp()), m_fps(fps)
+    {
+    }
+
+    auto IO::StreamWriter::writeFrame(const Data &frame) -> void
+    {
+        if (m_nrOfFrames == 0)
+        {
+            // write preliminary header. nrOfFrames and maxMemoryNeeded are patched after every frame
+            writeFileHeader(m_os, frame, 0, m_fps, 0);
+        }
+        IO::writeFrame(m_os, frame);
+        REQUIRE(!m_os.fail(), std::runtime_error, "Failed to write frame #" << m_nrOfFrames);
+        m_nrOfFrames++;
+        m_maxMemoryNeeded = m_maxMemoryNeeded < frame.maxMemoryNeeded ? frame.maxMemoryNeeded : m_maxMemoryNeeded;
+        // keep the header valid, so the file is playable up to the last frame written if the encoder is aborted
+        updateHeader();
+    }
+
+    auto IO::StreamWriter::finish() -> void
+    {
+        REQUIRE(m_nrOfFrames > 0, std::runtime_error, "No frames written");
+        updateHeader();
+    }
+
+    auto IO::StreamWriter::updateHeader() -> void
+    {
+        const auto endPosition = m_os.tellp();
+        // patch fields in file header that are only known after writing frames
+        m_os.seekp(m_headerPosition + static_cast<std::streamoff>(offsetof(FileHeader, nrOfFrames)));
+        m_os.write(reinterpret_cast<const char *>(&m_nrOfFrames), sizeof(m_nrOfFrames));
+        m_os.seekp(m_headerPosition + static_cast<std::streamoff>(offsetof(FileHeader, maxMemoryNeeded)));
+        m_os.write(reinterpret_cast<const char *>(&m_maxMemoryNeeded), sizeof(m_maxMemoryNeeded));
+        m_os.seekp(endPosition);
+        m_os.flush();
+        REQUIRE(!m_os.fail(), std::runtime_error, "Failed to update file header");
+    }
+
+    auto IO::StreamWriter::nrOfFrames() const -> uint32_t
+    {
+        return m_nrOfFrames;
+    }
+
+    auto IO::StreamWriter::maxMemoryNeeded() const -> uint32_t
+    {
+        return m_maxMemoryNeeded;
+    }
+
 }
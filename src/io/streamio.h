@@ -33,6 +33,43 @@ namespace Image
 
         /// @brief Write frames to output stream. Will get width / height / color format from first frame in vector
         static auto writeFileHeader(std::ostream &os, const std::vector<Data> &frames, uint8_t fps, uint32_t maxMemoryNeeded) -> std::ostream &;
+
+        /// @brief Write file header to output stream. Will get width / height / color format from frame passed
+        static auto writeFileHeader(std::ostream &os, const Data &firstFrame, uint32_t nrOfFrames, uint8_t fps, uint32_t maxMemoryNeeded) -> std::ostream &;
+
+        /// @brief Writes frames to a binary output stream as soon as they are produced, so frames don't need to be kept in memory.
+        /// The file header is written with the first frame and the fields only known at the end are updated in finish()
+        class StreamWriter
+        {
+        public:
+            /// @brief Constructor
+            /// @param os Output stream. Must be seekable, because the file header is updated after every frame
+            /// @param fps Frames / s to store in file header
+            StreamWriter(std::ostream &os, uint8_t fps);
+
+            /// @brief Write frame to output stream. Writes the file header before the first frame using width / height / color format of that frame.
+            /// Updates number of frames and max. memory needed in the file header after every frame and flushes the stream
+            auto writeFrame(const Data &frame) -> void;
+
+            /// @brief Check that frames were written and flush the final file header. Call after writing the last frame
+            auto finish() -> void;
+
+            /// @brief Number of frames written so far
+            auto nrOfFrames() const -> uint32_t;
+
+            /// @brief Max. intermediate memory needed to decompress any of the frames written so far
+            auto maxMemoryNeeded() const -> uint32_t;
+
+        private:
+            /// @brief Patch number of frames and max. memory needed in file header and flush stream
+            auto updateHeader() -> void;
+
+            std::ostream &m_os;
+            std::ostream::pos_type m_headerPosition;
+            uint8_t m_fps = 0;
+            uint32_t m_nrOfFrames = 0;
+            uint32_t m_maxMemoryNeeded = 0;
+        };
     };
 
 }
@@ -112,6 +112,45 @@ void writeImageDataToC(std::ofstream &cFile, const std::string &varName, const s
           << std::endl;
 }
 
+void writeChunkInfoToH(std::ofstream &hFile, const std::string &varName, uint32_t chunkSize, uint32_t nrOfChunks, uint32_t nrOfImages)
+{
+    hFile << "#define " << varName << "_CHUNK_SIZE " << chunkSize << " // uncompressed size of independently compressed chunks in bytes. The last chunk of an image may be smaller" << std::endl;
+    hFile << "#define " << varName << "_NR_OF_CHUNKS " << nrOfChunks << " // # of compressed chunks in data" << std::endl;
+    hFile << "extern const uint32_t " << varName << "_CHUNK_START[" << varName << "_NR_OF_CHUNKS]; // indices where compressed chunks start in data (in 4 byte units)" << std::endl;
+    if (nrOfImages > 1)
+    {
+        hFile << "extern const uint32_t " << varName << "_IMAGE_NR_OF_CHUNKS[" << varName << "_NR_OF_IMAGES]; // # of compressed chunks of an image" << std::endl;
+        hFile << "extern const uint32_t " << varName << "_IMAGE_CHUNK_START[" << varName << "_NR_OF_IMAGES]; // index of the first chunk of an image in _CHUNK_START" << std::endl;
+    }
+}
+
+void writeChunkDataToC(std::ofstream &cFile, const std::string &varName, const std::vector<uint32_t> &startIndices, const std::vector<uint32_t> &chunksPerImage)
+{
+    cFile << "const _Alignas(4) uint32_t " << varName << "_CHUNK_START[" << varName << "_NR_OF_CHUNKS] = { " << std::endl;
+    writeValues(cFile, startIndices);
+    cFile << "};" << std::endl
+          << std::endl;
+    // write chunk count and first chunk per image if more than one image
+    if (chunksPerImage.size() > 1)
+    {
+        std::vector<uint32_t> firstChunks;
+        uint32_t firstChunk = 0;
+        for (auto nrOfChunks : chunksPerImage)
+        {
+            firstChunks.push_back(firstChunk);
+            firstChunk += nrOfChunks;
+        }
+        cFile << "const _Alignas(4) uint32_t " << varName << "_IMAGE_NR_OF_CHUNKS[" << varName << "_NR_OF_IMAGES] = { " << std::endl;
+        writeValues(cFile, chunksPerImage);
+        cFile << "};" << std::endl
+              << std::endl;
+        cFile << "const _Alignas(4) uint32_t " << varName << "_IMAGE_CHUNK_START[" << varName << "_NR_OF_IMAGES] = { " << std::endl;
+        writeValues(cFile, firstChunks);
+        cFile << "};" << std::endl
+              << std::endl;
+    }
+}
+
 void writePaletteDataToC(std::ofstream &cFile, const std::string &varName, const std::vector<uint16_t> &data, const std::vector<uint32_t> &startIndices, bool asTiles)
 {
     // write palette start indices if more than one palette
@@ -12,5 +12,10 @@ void writeImageInfoToH(std::ofstream &hFile, const std::string &varName, const s
 void writePaletteInfoToHeader(std::ofstream &hFile, const std::string &varName, const std::vector<uint16_t> &data, uint32_t nrOfColors, bool singleColorMap = true, bool asTiles = false);
 /// @brief Write image data to a .c file.
 void writeImageDataToC(std::ofstream &cFile, const std::string &varName, const std::string &hFileBaseName, const std::vector<uint32_t> &data, const std::vector<uint32_t> &startIndices = std::vector<uint32_t>(), const std::vector<uint32_t> &mapData = std::vector<uint32_t>(), bool asTiles = false);
+/// @brief Write information about independently compressed chunks to a .h file. Use after writeImageInfoToH.
+/// Per-image chunk information is only written for more than one image.
+void writeChunkInfoToH(std::ofstream &hFile, const std::string &varName, uint32_t chunkSize, uint32_t nrOfChunks, uint32_t nrOfImages = 1);
+/// @brief Write chunk start indices and the number of chunks per image to a .c file. Use after writeImageDataToC.
+void writeChunkDataToC(std::ofstream &cFile, const std::string &varName, const std::vector<uint32_t> &startIndices, const std::vector<uint32_t> &chunksPerImage = std::vector<uint32_t>());
 /// @brief Write palette data to a .c file. Use after write writeImageDataToC.
 void writePaletteDataToC(std::ofstream &cFile, const std::string &varName, const std::vector<uint16_t> &data, const std::vector<uint32_t> &startIndices = std::vector<uint32_t>(), bool asTiles = false);
@@ -9,6 +9,14 @@ extern "C"
 }
 
 #include "exception.h"
+#include "processing/boundedqueue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 static AVPixelFormat CorrectDeprecatedPixelFormat(AVPixelFormat format)
 {
@@ -39,13 +47,30 @@ struct VideoReader::ReaderState
     int width = 0;
     int height = 0;
     float fps = 0;
+    AVRational frameRate{};
     AVRational timeBase{};
     int64_t nrOfFrames = 0;
     int64_t duration = 0;
+    int64_t startTime = 0;
     AVCodecContext *codecContext = nullptr;
     AVFrame *frame = nullptr;
     AVPacket *packet = nullptr;
     SwsContext *swsContext = nullptr;
+    VideoReader::CropRect crop;                                    // source rectangle to crop frames to
+    int outWidth = 0;                                              // output frame width after cropping and scaling
+    int outHeight = 0;                                             // output frame height after cropping and scaling
+    double outFps = 0;                                             // output frame rate after dropping frames
+    int64_t decodedFrames = 0;                                     // number of frames decoded so far
+    int64_t lastOutputSlot = -1;                                   // output frame time slot of the last frame kept
+    uint64_t startFrame = 0;                                       // first source frame to return
+    uint64_t endFrame = 0;                                         // source frame to stop at (exclusive). 0 = until end of video
+    bool endReached = false;                                       // true if endFrame was reached
+    bool flushed = false;                                          // true if the end of the file was reached and the decoder was flushed
+    std::unique_ptr<BoundedQueue<std::vector<uint8_t>>> readAhead; // frames decoded and converted in advance by read-ahead thread
+    std::thread readAheadThread;
+    std::exception_ptr readAheadError;
+    std::mutex freeFramesMutex;
+    std::vector<std::vector<uint8_t>> freeFrames; // recycled frame buffers for read-ahead thread
 };
 
 VideoReader::VideoReader()
@@ -59,6 +84,11 @@ VideoReader::~VideoReader()
 }
 
 void VideoReader::open(const std::string &filePath)
+{
+    open(filePath, DecodeOptions());
+}
+
+void VideoReader::open(const std::string &filePath, const DecodeOptions &options)
 {
     REQUIRE(!filePath.empty(), std::runtime_error, "Empty file path passed");
     REQUIRE(m_state->formatContext == nullptr, std::runtime_error, "Reader already open. Call close() first");
@@ -94,9 +124,11 @@ void VideoReader::open(const std::string &filePath)
                 m_state->width = codecParams->width;
                 m_state->height = codecParams->height;
                 m_state->fps = av_q2d(stream->r_frame_rate);
+                m_state->frameRate = stream->r_frame_rate;
                 m_state->timeBase = stream->time_base;
                 m_state->nrOfFrames = stream->nb_frames;
                 m_state->duration = stream->duration;
+                m_state->startTime = stream->start_time;
                 break;
             }
         }
@@ -106,6 +138,34 @@ void VideoReader::open(const std::string &filePath)
         close();
         THROW(std::runtime_error, "Failed to find video stream");
     }
+    // Check and set up cropping, scaling and frame rate
+    const auto &crop = options.crop;
+    const bool doCrop = crop.width > 0 && crop.height > 0;
+    if (doCrop && (crop.left + crop.width > static_cast<uint32_t>(m_state->width) || crop.top + crop.height > static_cast<uint32_t>(m_state->height)))
+    {
+        close();
+        THROW(std::runtime_error, "Crop rectangle must be inside of video frame");
+    }
+    m_state->crop = doCrop ? crop : CropRect{0, 0, static_cast<uint32_t>(m_state->width), static_cast<uint32_t>(m_state->height)};
+    m_state->outWidth = options.width > 0 ? static_cast<int>(options.width) : static_cast<int>(m_state->crop.width);
+    m_state->outHeight = options.height > 0 ? static_cast<int>(options.height) : static_cast<int>(m_state->crop.height);
+    if (options.fps < 0 || options.fps > m_state->fps)
+    {
+        close();
+        THROW(std::runtime_error, "Output frame rate must be in (0, " << m_state->fps << "]");
+    }
+    m_state->outFps = options.fps > 0 ? options.fps : m_state->fps;
+    if (options.endFrame > 0 && options.endFrame <= options.startFrame)
+    {
+        close();
+        THROW(std::runtime_error, "End frame must be > start frame");
+    }
+    m_state->startFrame = options.startFrame;
+    m_state->endFrame = options.endFrame;
+    m_state->endReached = false;
+    m_state->decodedFrames = 0;
+    // the frame before the start frame decides if the first frame is dropped, so segments of a video resample the same as the whole video
+    m_state->lastOutputSlot = m_state->startFrame > 0 ? static_cast<int64_t>(std::floor((m_state->startFrame - 1) / m_state->fps * m_state->outFps + 0.001)) : -1;
     // Set up a codec context for the decoder
     m_state->codecContext = avcodec_alloc_context3(m_state->codec);
     if (m_state->codecContext == nullptr)
@@ -118,6 +178,9 @@ void VideoReader::open(const std::string &filePath)
         close();
         THROW(std::runtime_error, "Failed to initialize AVCodecContext");
     }
+    // Use multi-threaded decoding. Must be set before opening the codec
+    m_state->codecContext->thread_count = static_cast<int>(options.nrOfThreads);
+    m_state->codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
     if (avcodec_open2(m_state->codecContext, m_state->codec, nullptr) < 0)
     {
         close();
@@ -136,24 +199,101 @@ void VideoReader::open(const std::string &filePath)
         close();
         THROW(std::runtime_error, "Failed to allocate packet");
     }
+    m_state->flushed = false;
+    // Seek to key frame before start frame. decodeFrame() discards the frames up to the start frame
+    if (m_state->startFrame > 0)
+    {
+        const AVRational frameDuration = {m_state->frameRate.den, m_state->frameRate.num};
+        auto timeStamp = av_rescale_q(static_cast<int64_t>(m_state->startFrame), frameDuration, m_state->timeBase);
+        timeStamp += m_state->startTime != AV_NOPTS_VALUE ? m_state->startTime : 0;
+        if (av_seek_frame(m_state->formatContext, m_state->videoStreamIndex, timeStamp, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            close();
+            THROW(std::runtime_error, "Failed to seek to start frame " << m_state->startFrame);
+        }
+        avcodec_flush_buffers(m_state->codecContext);
+    }
+    // Start decoding frames in advance
+    if (options.readAheadFrames > 0)
+    {
+        m_state->readAheadError = nullptr;
+        m_state->readAhead = std::make_unique<BoundedQueue<std::vector<uint8_t>>>(options.readAheadFrames);
+        m_state->readAheadThread = std::thread(&VideoReader::readAhead, this);
+    }
 }
 
 VideoReader::VideoInfo VideoReader::getInfo() const
 {
     REQUIRE(m_state->formatContext != nullptr, std::runtime_error, "Reader not open. Call open() first");
     auto duration = static_cast<float>(static_cast<double>(m_state->duration) * static_cast<double>(m_state->timeBase.num) / static_cast<double>(m_state->timeBase.den));
-    return {m_state->codecName, static_cast<uint32_t>(m_state->videoStreamIndex), static_cast<uint32_t>(m_state->width), static_cast<uint32_t>(m_state->height), m_state->fps, static_cast<uint64_t>(m_state->nrOfFrames), duration};
+    // only frames in [startFrame, endFrame) are read
+    auto nrOfFrames = m_state->endFrame > 0 && static_cast<uint64_t>(m_state->nrOfFrames) > m_state->endFrame ? static_cast<int64_t>(m_state->endFrame) : m_state->nrOfFrames;
+    nrOfFrames = nrOfFrames > static_cast<int64_t>(m_state->startFrame) ? nrOfFrames - static_cast<int64_t>(m_state->startFrame) : 0;
+    // when dropping frames we output one frame per output frame rate interval
+    nrOfFrames = m_state->outFps < m_state->fps ? static_cast<int64_t>(std::ceil(nrOfFrames * m_state->outFps / m_state->fps)) : nrOfFrames;
+    return {m_state->codecName, static_cast<uint32_t>(m_state->videoStreamIndex), static_cast<uint32_t>(m_state->outWidth), static_cast<uint32_t>(m_state->outHeight), m_state->outFps, static_cast<uint64_t>(nrOfFrames), duration};
 }
 
-std::vector<uint8_t> VideoReader::readFrame() const
+bool VideoReader::decodeFrame() const
 {
     while (true)
     {
+        // try to get a decoded frame first. one packet might contain multiple frames
+        if (m_state->endReached)
+        {
+            return false;
+        }
+        auto receiveResult = avcodec_receive_frame(m_state->codecContext, m_state->frame);
+        if (receiveResult == 0)
+        {
+            // get source frame time and number. without timestamps we assume constant frame rate and decoding from the first frame
+            const auto timeStamp = m_state->frame->best_effort_timestamp;
+            const double frameTime = timeStamp != AV_NOPTS_VALUE ? (timeStamp - (m_state->startTime != AV_NOPTS_VALUE ? m_state->startTime : 0)) * av_q2d(m_state->timeBase) : m_state->decodedFrames / m_state->fps;
+            const auto frameNumber = std::llround(frameTime * m_state->fps);
+            m_state->decodedFrames++;
+            // discard frames between the key frame we seeked to and the start frame
+            if (frameNumber < static_cast<int64_t>(m_state->startFrame))
+            {
+                av_frame_unref(m_state->frame);
+                continue;
+            }
+            if (m_state->endFrame > 0 && frameNumber >= static_cast<int64_t>(m_state->endFrame))
+            {
+                av_frame_unref(m_state->frame);
+                m_state->endReached = true;
+                return false;
+            }
+            if (m_state->outFps < m_state->fps)
+            {
+                // keep only the first frame in every output frame interval. drop the others before converting them
+                const auto outputSlot = static_cast<int64_t>(std::floor(frameTime * m_state->outFps + 0.001));
+                if (outputSlot <= m_state->lastOutputSlot)
+                {
+                    av_frame_unref(m_state->frame);
+                    continue;
+                }
+                m_state->lastOutputSlot = outputSlot;
+            }
+            return true;
+        }
+        else if (receiveResult == AVERROR_EOF)
+        {
+            return false;
+        }
+        REQUIRE(receiveResult == AVERROR(EAGAIN), std::runtime_error, "Failed to decode packet");
+        // decoder needs more data
+        if (m_state->flushed)
+        {
+            return false;
+        }
         auto readResult = av_read_frame(m_state->formatContext, m_state->packet);
         if (readResult < 0)
         {
+            // end of file. flush decoder to get the frames it still holds, e.g. when decoding with multiple threads
             av_packet_unref(m_state->packet);
-            return {};
+            REQUIRE(avcodec_send_packet(m_state->codecContext, nullptr) >= 0, std::runtime_error, "Failed to flush decoder");
+            m_state->flushed = true;
+            continue;
         }
         // check if it is the correct stream index
         if (m_state->packet->stream_index != m_state->videoStreamIndex)
@@ -162,53 +302,217 @@ std::vector<uint8_t> VideoReader::readFrame() const
             continue;
         }
         // send packet to codec
-        REQUIRE(avcodec_send_packet(m_state->codecContext, m_state->packet) >= 0, std::runtime_error, "Failed to decode packet");
-        // try to decode frame
-        auto receiveResult = avcodec_receive_frame(m_state->codecContext, m_state->frame);
-        if (receiveResult == AVERROR_EOF)
-        {
-            avcodec_flush_buffers(m_state->codecContext);
-            av_packet_unref(m_state->packet);
-            return {};
-        }
-        else if (receiveResult == AVERROR(EAGAIN))
+        auto sendResult = avcodec_send_packet(m_state->codecContext, m_state->packet);
+        av_packet_unref(m_state->packet);
+        REQUIRE(sendResult >= 0, std::runtime_error, "Failed to decode packet");
+    }
+}
+
+std::vector<uint64_t> VideoReader::findKeyFrames(const std::string &filePath)
+{
+    REQUIRE(!filePath.empty(), std::runtime_error, "Empty file path passed");
+    AVFormatContext *formatContext = avformat_alloc_context();
+    REQUIRE(formatContext != nullptr, std::runtime_error, "Failed to create AVFormatContext");
+    if (avformat_open_input(&formatContext, filePath.c_str(), nullptr, nullptr) != 0)
+    {
+        avformat_free_context(formatContext);
+        THROW(std::runtime_error, "Failed to open video file");
+    }
+    AVPacket *packet = av_packet_alloc();
+    auto cleanUp = [&]()
+    {
+        av_packet_free(&packet);
+        avformat_close_input(&formatContext);
+    };
+    if (packet == nullptr || avformat_find_stream_info(formatContext, nullptr) < 0)
+    {
+        cleanUp();
+        THROW(std::runtime_error, "Failed to find stream info");
+    }
+    // use the same video stream as open()
+    const AVStream *stream = nullptr;
+    for (decltype(formatContext->nb_streams) i = 0; i < formatContext->nb_streams; i++)
+    {
+        auto codecParams = formatContext->streams[i]->codecpar;
+        if (codecParams != nullptr && codecParams->codec_type == AVMEDIA_TYPE_VIDEO && avcodec_find_decoder(codecParams->codec_id) != nullptr)
         {
-            av_packet_unref(m_state->packet);
-            continue;
+            stream = formatContext->streams[i];
+            break;
         }
-        else if (receiveResult < 0)
+    }
+    if (stream == nullptr)
+    {
+        cleanUp();
+        THROW(std::runtime_error, "Failed to find video stream");
+    }
+    // read all packets of the stream and convert key frame timestamps to frame numbers
+    const auto startTime = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    const auto timeBase = av_q2d(stream->time_base);
+    const auto fps = av_q2d(stream->r_frame_rate);
+    std::vector<uint64_t> keyFrames;
+    uint64_t packetIndex = 0;
+    while (av_read_frame(formatContext, packet) >= 0)
+    {
+        if (packet->stream_index == stream->index)
         {
-            THROW(std::runtime_error, "Failed to decode packet");
+            if (packet->flags & AV_PKT_FLAG_KEY)
+            {
+                const auto timeStamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                const auto frameNumber = timeStamp != AV_NOPTS_VALUE ? std::llround((timeStamp - startTime) * timeBase * fps) : static_cast<int64_t>(packetIndex);
+                keyFrames.push_back(frameNumber > 0 ? static_cast<uint64_t>(frameNumber) : 0);
+            }
+            packetIndex++;
         }
-        // here the frame has been successfully decoded
-        av_packet_unref(m_state->packet);
-        break;
+        av_packet_unref(packet);
     }
+    cleanUp();
+    std::sort(keyFrames.begin(), keyFrames.end());
+    keyFrames.erase(std::unique(keyFrames.begin(), keyFrames.end()), keyFrames.end());
+    return keyFrames;
+}
+
+void VideoReader::convertFrame(uint8_t *dst, std::size_t stride) const
+{
     // auto timeStamp = m_state->frame->pts; // timestamp when the frame should be shown
-    // set up sw scaler for pixel format conversion
+    // crop frame. this only adjusts the data pointers
+    const auto &crop = m_state->crop;
+    m_state->frame->crop_left = crop.left;
+    m_state->frame->crop_top = crop.top;
+    m_state->frame->crop_right = m_state->frame->width - (crop.left + crop.width);
+    m_state->frame->crop_bottom = m_state->frame->height - (crop.top + crop.height);
+    REQUIRE(av_frame_apply_cropping(m_state->frame, AV_FRAME_CROP_UNALIGNED) >= 0, std::runtime_error, "Failed to crop frame");
+    // set up sw scaler for pixel format conversion and scaling
     if (m_state->swsContext == nullptr)
     {
         auto sourcePixelFormat = CorrectDeprecatedPixelFormat(m_state->codecContext->pix_fmt);
-        m_state->swsContext = sws_getContext(m_state->width, m_state->height, sourcePixelFormat,
-                                             m_state->width, m_state->height, AV_PIX_FMT_RGB24,
-                                             SWS_BILINEAR, nullptr, nullptr, nullptr);
+        const bool downScaling = m_state->outWidth < m_state->frame->width || m_state->outHeight < m_state->frame->height;
+        m_state->swsContext = sws_getContext(m_state->frame->width, m_state->frame->height, sourcePixelFormat,
+                                             m_state->outWidth, m_state->outHeight, AV_PIX_FMT_RGB24,
+                                             downScaling ? SWS_AREA : SWS_BILINEAR, nullptr, nullptr, nullptr);
         if (m_state->swsContext == nullptr)
         {
             THROW(std::runtime_error, "Failed to create sw scaler");
         }
     }
-    // convert pixel format using sw scaler
-    std::vector<uint8_t> frame(m_state->width * m_state->height * 3);
-    uint8_t *const dst[4] = {frame.data(), nullptr, nullptr, nullptr};
-    int const dstStride[4] = {m_state->width * 3, 0, 0, 0};
-    sws_scale(m_state->swsContext, m_state->frame->data, m_state->frame->linesize, 0, m_state->frame->height, dst, dstStride);
+    // convert pixel format using sw scaler directly into destination
+    uint8_t *const dstData[4] = {dst, nullptr, nullptr, nullptr};
+    int const dstStride[4] = {static_cast<int>(stride), 0, 0, 0};
+    sws_scale(m_state->swsContext, m_state->frame->data, m_state->frame->linesize, 0, m_state->frame->height, dstData, dstStride);
     // release FFmpeg frame
     av_frame_unref(m_state->frame);
-    return frame;
+}
+
+void VideoReader::readAhead() const
+{
+    try
+    {
+        const std::size_t frameSize = m_state->outWidth * m_state->outHeight * 3;
+        while (decodeFrame())
+        {
+            // get recycled frame buffer or allocate a new one
+            std::vector<uint8_t> frame;
+            {
+                std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+                if (!m_state->freeFrames.empty())
+                {
+                    frame = std::move(m_state->freeFrames.back());
+                    m_state->freeFrames.pop_back();
+                }
+            }
+            frame.resize(frameSize);
+            convertFrame(frame.data(), m_state->outWidth * 3);
+            if (!m_state->readAhead->push(std::move(frame)))
+            {
+                // reader was closed
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        m_state->readAheadError = std::current_exception();
+    }
+    m_state->readAhead->close();
+}
+
+std::vector<uint8_t> VideoReader::readFrame() const
+{
+    std::vector<uint8_t> frame;
+    return readFrame(frame) ? frame : std::vector<uint8_t>();
+}
+
+bool VideoReader::readFrame(std::vector<uint8_t> &frame) const
+{
+    if (m_state->readAhead)
+    {
+        auto decoded = m_state->readAhead->pop();
+        if (!decoded)
+        {
+            if (m_state->readAheadError)
+            {
+                std::rethrow_exception(m_state->readAheadError);
+            }
+            return false;
+        }
+        // swap buffers and recycle the callers old buffer
+        frame.swap(*decoded);
+        if (decoded->size() == frame.size())
+        {
+            std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+            m_state->freeFrames.push_back(std::move(*decoded));
+        }
+        return true;
+    }
+    const std::size_t frameSize = m_state->outWidth * m_state->outHeight * 3;
+    if (frame.size() != frameSize)
+    {
+        frame.resize(frameSize);
+    }
+    return readFrame(frame.data(), m_state->outWidth * 3);
+}
+
+bool VideoReader::readFrame(uint8_t *dst, std::size_t stride) const
+{
+    REQUIRE(dst != nullptr, std::runtime_error, "Destination can not be nullptr");
+    const std::size_t lineSize = m_state->outWidth * 3;
+    REQUIRE(stride >= lineSize, std::runtime_error, "Stride must be >= width * 3");
+    if (m_state->readAhead)
+    {
+        // copy frame from read-ahead queue
+        std::vector<uint8_t> frame;
+        if (!readFrame(frame))
+        {
+            return false;
+        }
+        for (int y = 0; y < m_state->outHeight; y++)
+        {
+            std::memcpy(dst + y * stride, frame.data() + y * lineSize, lineSize);
+        }
+        std::lock_guard<std::mutex> lock(m_state->freeFramesMutex);
+        m_state->freeFrames.push_back(std::move(frame));
+        return true;
+    }
+    if (!decodeFrame())
+    {
+        return false;
+    }
+    convertFrame(dst, stride);
+    return true;
 }
 
 void VideoReader::close()
 {
+    // stop read-ahead thread before releasing FFmpeg resources
+    if (m_state->readAhead)
+    {
+        m_state->readAhead->close();
+        if (m_state->readAheadThread.joinable())
+        {
+            m_state->readAheadThread.join();
+        }
+        m_state->readAhead.reset();
+        m_state->freeFrames.clear();
+    }
     if (m_state->packet)
     {
         av_packet_free(&m_state->packet);
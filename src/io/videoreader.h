@@ -21,6 +21,28 @@ public:
         double durationS = 0;
     };
 
+    /// @brief Rectangle in source video to crop frames to
+    struct CropRect
+    {
+        uint32_t left = 0;
+        uint32_t top = 0;
+        uint32_t width = 0; // 0 = no cropping
+        uint32_t height = 0;
+    };
+
+    /// @brief Options for decoding video
+    struct DecodeOptions
+    {
+        uint32_t nrOfThreads = 0;     // Number of FFmpeg frame / slice decoding threads. 0 = automatic
+        uint32_t readAheadFrames = 0; // Number of frames to decode and convert to RGB888 in advance on a background thread. 0 = no read-ahead
+        CropRect crop;                // Crop frames to this rectangle before scaling
+        uint32_t width = 0;           // Scale frames to this width. 0 = source / crop width
+        uint32_t height = 0;          // Scale frames to this height. 0 = source / crop height
+        double fps = 0;               // Drop frames to reduce frame rate to this. Must be <= source frame rate. 0 = source frame rate
+        uint64_t startFrame = 0;      // First source frame to return. The reader seeks to the key frame before it and discards the frames in between
+        uint64_t endFrame = 0;        // Source frame to stop reading at (exclusive). 0 = until end of video
+    };
+
     /// @brief Constructor
     VideoReader();
 
@@ -31,16 +53,46 @@ public:
     /// @throw Throws a std::runtime_errror if anything goes wrong
     void open(const std::string &filePath);
 
-    /// @brief Get information about opened video file
+    /// @brief Open FFmpeg reader on a file so you can later getFrame() from it
+    /// @param options Options for multi-threaded decoding and read-ahead
+    /// @throw Throws a std::runtime_errror if anything goes wrong
+    void open(const std::string &filePath, const DecodeOptions &options);
+
+    /// @brief Get information about opened video file. Width, height, fps and number of frames are those of the frames returned by readFrame()
     VideoInfo getInfo() const;
 
+    /// @brief Scan video file for key frames. Only reads packets and does not decode, so this is fast
+    /// @return Returns source frame numbers of key frames in ascending order
+    /// @throw Throws a std::runtime_errror if anything goes wrong
+    static std::vector<uint64_t> findKeyFrames(const std::string &filePath);
+
     /// @brief Read next RGB888 frame from video. Will return empty data if EOF
     std::vector<uint8_t> readFrame() const;
 
+    /// @brief Read next RGB888 frame from video into a caller-provided buffer. The buffer is only resized if its size does not match the frame size, so buffers can be reused
+    /// @return Returns false if EOF
+    bool readFrame(std::vector<uint8_t> &frame) const;
+
+    /// @brief Read next RGB888 frame from video into caller-provided memory
+    /// @param dst Destination memory. Must hold at least height * stride bytes
+    /// @param stride Bytes per line in destination memory. Must be >= width * 3
+    /// @return Returns false if EOF
+    bool readFrame(uint8_t *dst, std::size_t stride) const;
+
     /// @brief Open FFmpeg reader opened with open()
     void close();
 
 private:
+    /// @brief Decode next frame from video into the reader state. Will skip frames not needed for the output frame rate
+    /// @return Returns false if EOF
+    bool decodeFrame() const;
+
+    /// @brief Crop, scale and convert frame decoded with decodeFrame() to RGB888 and release it
+    void convertFrame(uint8_t *dst, std::size_t stride) const;
+
+    /// @brief Read-ahead thread function. Decodes and converts frames until EOF or close()
+    void readAhead() const;
+
     struct ReaderState;
     std::shared_ptr<ReaderState> m_state;
 };
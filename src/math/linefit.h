@@ -5,29 +5,35 @@
 
 #include <array>
 
-/// @brief Fit a line through points passed using SVD
-/// @tparam T Value or struct type
-/// @tparam N Dimension of value block
-/// Found here: https://stackoverflow.com/questions/40589802/eigen-best-fit-of-a-plane-to-n-points
+/// @brief Fit a line through points passed using the principal axis of their covariance matrix.
+/// The axis is the eigenvector of the largest eigenvalue, which is the same as the first left singular vector of the centered points.
+/// Uses only fixed-size matrices and the closed-form 3x3 eigen-solver, so no memory is allocated
+/// @tparam T Value or struct type. Must be convertible to and from Eigen::Vector3d
+/// @tparam N Number of points
 /// See also: https://zalo.github.io/blog/line-fitting/
-/// See also: https://stackoverflow.com/questions/39370370/eigen-and-svd-to-find-best-fitting-plane-given-a-set-of-points
-/// See also: https://gist.github.com/ialhashim/0a2554076a6cf32831ca
+/// See also: https://eigen.tuxfamily.org/dox/classEigen_1_1SelfAdjointEigenSolver.html
 /// @return Returns line (origin, axis)
 template <typename T, std::size_t N>
 auto lineFit(const std::array<T, N> &p) -> std::pair<T, T>
 {
-    // copy coordinates to matrix in Eigen format
-    constexpr std::size_t NrOfAtoms = N;
-    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> points(3, NrOfAtoms);
-    for (std::size_t i = 0; i < NrOfAtoms; ++i)
+    static_assert(N > 0, "Need at least one point for line fit");
+    // calculate mean
+    Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+    for (const auto &v : p)
     {
-        points.col(i) = p[i];
+        mean += v;
     }
-    // center on mean
-    Eigen::Vector3d mean = points.rowwise().mean();
-    auto centered = points.colwise() - mean;
-    // calculate SVD and first eigenvector
-    auto svd = centered.jacobiSvd(Eigen::DecompositionOptions::ComputeFullU);
-    Eigen::Vector3d axis = svd.matrixU().col(0).transpose().normalized();
+    mean /= static_cast<double>(N);
+    // accumulate covariance matrix of points centered on mean. scaling it by 1/N does not change the eigenvectors
+    Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+    for (const auto &v : p)
+    {
+        const Eigen::Vector3d centered = v - mean;
+        covariance.noalias() += centered * centered.transpose();
+    }
+    // eigenvalues are sorted in increasing order, so the last eigenvector is the principal axis
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+    solver.computeDirect(covariance, Eigen::ComputeEigenvectors);
+    Eigen::Vector3d axis = solver.eigenvectors().col(2).normalized();
     return {T(mean), T(axis)};
 }
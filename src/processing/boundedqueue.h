@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/// @brief Thread-safe FIFO queue with a maximum number of items.
+/// Used to connect the stages of a threaded processing pipeline
+template <typename T>
+class BoundedQueue
+{
+public:
+    /// @brief Constructor
+    /// @param capacity Max. number of items in queue. push() will block if the queue is full
+    explicit BoundedQueue(std::size_t capacity)
+        : m_capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    /// @brief Add item to end of queue. Blocks while the queue is full
+    /// @return Returns false if the queue was closed and the item was not added
+    auto push(T &&item) -> bool
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]()
+                       { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+        {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /// @brief Remove item from front of queue. Blocks while the queue is empty
+    /// @return Returns std::nullopt if the queue was closed and all items have been removed
+    auto pop() -> std::optional<T>
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]()
+                        { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(m_items.front()));
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    /// @brief Close queue and wake up all waiting threads. push() will fail afterwards,
+    /// pop() will return the remaining items and then std::nullopt
+    auto close() -> void
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    std::size_t m_capacity;
+    bool m_closed = false;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
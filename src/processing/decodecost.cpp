@@ -0,0 +1,320 @@
+#include "decodecost.h"
+
+#include <algorithm>
+
+namespace DecodeCost
+{
+
+    using Image::ProcessingType;
+
+    /// @brief Count work for copying data in 32-bit units using Memory::memcpy32 (ldm / stm of 8 words)
+    static auto countMemcpy32(Operations &ops, uint32_t size) -> void
+    {
+        const uint64_t words = (size + 3) / 4;
+        ops.srcReads32 += words;
+        ops.dstWrites32 += words;
+        ops.cpuCycles += 20 + words / 2;
+    }
+
+    /// @brief Count work for Decompress::LZ77UnCompWrite8bit by parsing the LZ10 stream
+    static auto countLz10(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        ops.srcReads32++;
+        ops.cpuCycles += 20;
+        std::size_t src = 4;
+        uint32_t written = 0;
+        while (written < ops.uncompressedSize && src < data.size())
+        {
+            const auto flags = data[src++];
+            ops.srcReads8++;
+            ops.cpuCycles += 6;
+            for (uint32_t bit = 0; bit < 8 && written < ops.uncompressedSize && src < data.size(); bit++)
+            {
+                if ((flags & (0x80 >> bit)) == 0)
+                {
+                    src++;
+                    written++;
+                    ops.srcReads8++;
+                    ops.dstWrites8++;
+                    ops.cpuCycles += 5;
+                }
+                else if (src + 1 < data.size())
+                {
+                    const uint32_t length = (data[src] >> 4) + 3;
+                    src += 2;
+                    written += length;
+                    ops.srcReads8 += 2;
+                    ops.dstReads8 += length;
+                    ops.dstWrites8 += length;
+                    ops.cpuCycles += 10 + 4 * length;
+                }
+            }
+        }
+    }
+
+    /// @brief Count work for Decompress::LZInterUnCompWrite8bit by parsing the stream
+    static auto countLzInter(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        ops.srcReads32++;
+        ops.cpuCycles += 20;
+        std::size_t src = 4;
+        uint32_t written = 0;
+        while (written < ops.uncompressedSize && src < data.size())
+        {
+            const auto flags = data[src++];
+            ops.srcReads8++;
+            ops.cpuCycles += 6;
+            for (uint32_t bit = 0; bit < 8 && written < ops.uncompressedSize && src < data.size(); bit++)
+            {
+                if ((flags & (0x80 >> bit)) == 0)
+                {
+                    src++;
+                    written++;
+                    ops.srcReads8++;
+                    ops.dstWrites8++;
+                    ops.cpuCycles += 5;
+                    continue;
+                }
+                const uint32_t b0 = data[src++];
+                ops.srcReads8++;
+                if ((b0 & 0x80) != 0)
+                {
+                    const bool isLong = (b0 & 0x40) != 0;
+                    const uint32_t length = isLong && src < data.size() ? (((b0 & 0x3F) << 8) | data[src]) + 67 : (b0 & 0x3F) + 3;
+                    src += isLong ? 2 : 1;
+                    const auto offset = src <= data.size() ? data[src - 1] : 0;
+                    written += length;
+                    ops.srcReads8 += isLong ? 2 : 1;
+                    ops.cpuCycles += 12;
+                    // unchanged data is skipped
+                    if (offset != 0)
+                    {
+                        ops.dstReads8 += length;
+                        ops.dstWrites8 += length;
+                        ops.cpuCycles += 4 * length;
+                    }
+                }
+                else
+                {
+                    const uint32_t length = (b0 >> 3) + 3;
+                    src++;
+                    written += length;
+                    ops.srcReads8++;
+                    ops.dstReads8 += length;
+                    ops.dstWrites8 += length;
+                    ops.cpuCycles += 10 + 4 * length;
+                }
+            }
+        }
+    }
+
+    /// @brief Count work for BIOS::RLUnCompReadNormalWrite8bit by parsing the RLE stream
+    static auto countRle(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        // BIOS call overhead
+        ops.srcReads32++;
+        ops.cpuCycles += 60;
+        std::size_t src = 4;
+        uint32_t written = 0;
+        while (written < ops.uncompressedSize && src < data.size())
+        {
+            const auto flag = data[src++];
+            ops.srcReads8++;
+            ops.cpuCycles += 10;
+            if ((flag & 0x80) != 0)
+            {
+                const uint32_t length = (flag & 0x7F) + 3;
+                src++;
+                written += length;
+                ops.srcReads8++;
+                ops.dstWrites8 += length;
+                ops.cpuCycles += 5 * length;
+            }
+            else
+            {
+                const uint32_t length = (flag & 0x7F) + 1;
+                src += length;
+                written += length;
+                ops.srcReads8 += length;
+                ops.dstWrites8 += length;
+                ops.cpuCycles += 6 * length;
+            }
+        }
+    }
+
+    /// @brief Count work for BIOS::HuffUnCompReadNormal. The BIOS walks the tree in the source data for every bit
+    static auto countHuffman(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        ops.srcReads32++;
+        ops.cpuCycles += 60;
+        if (data.size() < 5)
+        {
+            return;
+        }
+        const std::size_t treeSize = (static_cast<std::size_t>(data[4]) + 1) * 2;
+        const uint64_t bits = data.size() > 4 + treeSize ? (data.size() - 4 - treeSize) * 8 : 0;
+        ops.srcReads32 += bits / 32;
+        ops.srcReads8 += bits;
+        ops.dstWrites32 += (ops.uncompressedSize + 3) / 4;
+        ops.cpuCycles += 9 * bits + 6 * ((ops.uncompressedSize + 3) / 4);
+    }
+
+    /// @brief Count work for Decompress::RansUnCompWrite8bit
+    static auto countRans(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        ops.srcReads32++;
+        ops.cpuCycles += 20;
+        // read frequency table and fill 4096 entry slot table in IWRAM
+        std::size_t src = 4;
+        for (uint32_t s = 0; s < 256 && src < data.size();)
+        {
+            const auto b = data[src++];
+            ops.srcReads8++;
+            ops.cpuCycles += 8;
+            if (b == 0)
+            {
+                s += (src < data.size() ? data[src] : 255) + 1;
+                src++;
+                ops.srcReads8++;
+                continue;
+            }
+            src += (b & 0x80) != 0 ? 1 : 0;
+            ops.iwramAccesses += 2;
+            s++;
+        }
+        ops.iwramAccesses += 4096;
+        ops.cpuCycles += 2 * 4096;
+        // initial state, then one table lookup, multiply and write per byte and a 16-bit read per renormalization
+        src = (src + 3) & ~std::size_t(3);
+        ops.srcReads32++;
+        ops.srcReads16 += data.size() > src + 4 ? (data.size() - src - 4) / 2 : 0;
+        ops.iwramAccesses += 3 * static_cast<uint64_t>(ops.uncompressedSize);
+        ops.dstWrites8 += ops.uncompressedSize;
+        ops.cpuCycles += 14 * static_cast<uint64_t>(ops.uncompressedSize) + 3 * ops.srcReads16;
+    }
+
+    /// @brief Count work for DXTV::UnCompWrite16bit. The split flags are not parsed. The data size limits how many 4x4 DXT blocks
+    /// (8 bytes each) a frame can contain, all other pixels are assumed to be copied from reference blocks in 4x4 blocks
+    static auto countDxtv(Operations &ops, const std::vector<uint8_t> &data) -> void
+    {
+        constexpr uint16_t FrameKeep = 0x40;
+        ops.srcReads16++;
+        ops.cpuCycles += 40;
+        if (data.size() < 4 || (data[0] & FrameKeep) != 0)
+        {
+            return;
+        }
+        const uint64_t pixels = ops.uncompressedSize / 2;
+        const uint64_t dxtBlocks = std::min<uint64_t>(pixels / 16, (data.size() - 4) / 8);
+        const uint64_t refBlocks = (pixels - dxtBlocks * 16) / 16;
+        // split flags per 16x16 block
+        ops.srcReads16 += 1 + pixels / 256 / 8;
+        ops.cpuCycles += 15 * (pixels / 256);
+        // DXT blocks: colors, C2C3 table lookups, indices and 16 pixel writes
+        ops.srcReads16 += 4 * dxtBlocks;
+        ops.iwramAccesses += (3 + 4 + 16) * dxtBlocks;
+        ops.dstWrites16 += 16 * dxtBlocks;
+        ops.cpuCycles += (40 + 2 * 16) * dxtBlocks;
+        // reference blocks: flags and 4 lines of 2 words copied from the previous frame in VRAM or the current frame
+        ops.srcReads16 += refBlocks;
+        ops.vramReads32 += 8 * refBlocks;
+        ops.dstWrites32 += 8 * refBlocks;
+        ops.cpuCycles += (25 + 8) * refBlocks;
+    }
+
+    auto countOperations(ProcessingType type, const std::vector<uint8_t> &data, uint32_t uncompressedSize) -> Operations
+    {
+        Operations ops;
+        ops.type = type;
+        ops.uncompressedSize = uncompressedSize;
+        switch (type)
+        {
+        case ProcessingType::Uncompressed:
+            countMemcpy32(ops, uncompressedSize);
+            break;
+        case ProcessingType::CompressLz10:
+            countLz10(ops, data);
+            break;
+        case ProcessingType::CompressLzInter:
+            countLzInter(ops, data);
+            break;
+        case ProcessingType::CompressRLE:
+            countRle(ops, data);
+            break;
+        case ProcessingType::CompressHuffman:
+            countHuffman(ops, data);
+            break;
+        case ProcessingType::CompressRANS:
+            countRans(ops, data);
+            break;
+        case ProcessingType::CompressDXTV:
+            countDxtv(ops, data);
+            break;
+        default:
+            // Video::decode stops at chunk types it can not decode
+            ops.supported = false;
+            break;
+        }
+        return ops;
+    }
+
+    /// @brief Cycles for one access of bitWidth to region. Assumes mostly sequential access with the prefetch buffer on for ROM
+    static auto accessCycles(Region region, uint32_t bitWidth, const Setup &setup) -> uint64_t
+    {
+        switch (region)
+        {
+        case Region::IWRAM:
+            return 1;
+        case Region::EWRAM:
+            return bitWidth == 32 ? 2 * (1 + setup.ewramWaitStates) : 1 + setup.ewramWaitStates;
+        case Region::VRAM:
+            return bitWidth == 32 ? 2 : 1;
+        case Region::ROM:
+            return bitWidth == 32 ? 2 * (1 + setup.romSequentialWaitStates) : 1 + setup.romSequentialWaitStates;
+        }
+        return 1;
+    }
+
+    auto cycles(const Operations &operations, Region src, Region dst, const Setup &setup) -> uint64_t
+    {
+        uint64_t result = operations.cpuCycles;
+        result += operations.srcReads8 * accessCycles(src, 8, setup);
+        result += operations.srcReads16 * accessCycles(src, 16, setup);
+        result += operations.srcReads32 * accessCycles(src, 32, setup);
+        result += operations.dstReads8 * accessCycles(dst, 8, setup);
+        result += operations.dstWrites8 * accessCycles(dst, 8, setup);
+        result += operations.dstWrites16 * accessCycles(dst, 16, setup);
+        result += operations.dstWrites32 * accessCycles(dst, 32, setup);
+        result += operations.vramReads32 * accessCycles(Region::VRAM, 32, setup);
+        result += operations.iwramAccesses * accessCycles(Region::IWRAM, 32, setup);
+        // the first access to ROM is non-sequential
+        result += src == Region::ROM ? setup.romFirstWaitStates - setup.romSequentialWaitStates : 0;
+        return result;
+    }
+
+    auto estimateFrame(const std::vector<Operations> &chunks, uint32_t frameSize, const Setup &setup) -> FrameEstimate
+    {
+        FrameEstimate result;
+        Operations blit;
+        if (chunks.empty())
+        {
+            // frame data is copied to the screen directly
+            countMemcpy32(blit, frameSize);
+            result.cycles = cycles(blit, setup.frameSource, setup.blitDestination, setup);
+            return result;
+        }
+        // chunks are decoded in reverse order of creation. the first one is read from the frame source
+        auto src = setup.frameSource;
+        for (auto cIt = chunks.crbegin(); cIt != chunks.crend(); ++cIt)
+        {
+            result.supported = result.supported && cIt->supported;
+            result.cycles += cycles(*cIt, src, setup.scratchPad, setup);
+            src = setup.scratchPad;
+        }
+        // the decoded frame is copied from the scratch pad to the screen
+        countMemcpy32(blit, chunks.front().uncompressedSize);
+        result.cycles += cycles(blit, setup.scratchPad, setup.blitDestination, setup);
+        return result;
+    }
+
+}
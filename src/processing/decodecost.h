@@ -0,0 +1,82 @@
+#pragma once
+
+#include "processingtypes.h"
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Estimates how many CPU cycles the GBA player in gba/video needs to decode data chunks.
+/// Decoding work is counted per chunk when it is created, independent of where it is stored. Cycles are calculated from that work
+/// when the memory regions the decoder reads from and writes to are known. Instruction cycles are rough averages of the decoders' inner loops
+namespace DecodeCost
+{
+
+    /// @brief GBA CPU clock in Hz
+    constexpr double CyclesPerSecond = 16 * 1024 * 1024;
+
+    /// @brief GBA memory regions with different access times
+    enum class Region : uint8_t
+    {
+        IWRAM, // 32-bit bus, no wait states
+        EWRAM, // 16-bit bus, wait states configurable
+        VRAM,  // 16-bit bus, no wait states. No 8-bit writes possible
+        ROM    // 16-bit bus, wait states configurable. Read-only
+    };
+
+    /// @brief Memory setup of the player. Defaults match gba/video.cpp
+    struct Setup
+    {
+        Region frameSource = Region::ROM;      // Where compressed frames are read from
+        Region scratchPad = Region::EWRAM;     // Where intermediate and decoded frames are stored
+        Region blitDestination = Region::VRAM; // Where the decoded frame is copied to for display
+        uint32_t ewramWaitStates = 2;          // Memory::WaitEwramNormal (3/3/6 cycles)
+        uint32_t romFirstWaitStates = 2;       // Memory::WaitCntFast, WS0 first access (3 cycles)
+        uint32_t romSequentialWaitStates = 1;  // Memory::WaitCntFast, WS0 sequential access (2 cycles)
+    };
+
+    /// @brief Memory accesses and instruction cycles needed to decode one data chunk
+    struct Operations
+    {
+        Image::ProcessingType type = Image::ProcessingType::Uncompressed; // Chunk type as stored in the chunk header
+        bool supported = true;                                            // False if the GBA player has no decoder for this chunk type
+        uint32_t uncompressedSize = 0;                                    // Size of data after decoding the chunk
+        uint64_t srcReads8 = 0;                                           // 8-bit reads from the chunk data
+        uint64_t srcReads16 = 0;                                          // 16-bit reads from the chunk data
+        uint64_t srcReads32 = 0;                                          // 32-bit reads from the chunk data
+        uint64_t dstReads8 = 0;                                           // 8-bit reads from the destination, e.g. LZ77 matches
+        uint64_t dstWrites8 = 0;                                          // 8-bit writes to the destination
+        uint64_t dstWrites16 = 0;                                         // 16-bit writes to the destination
+        uint64_t dstWrites32 = 0;                                         // 32-bit writes to the destination
+        uint64_t vramReads32 = 0;                                         // 32-bit reads from VRAM, e.g. DXTV previous frame blocks
+        uint64_t iwramAccesses = 0;                                       // Accesses to decoder tables in IWRAM
+        uint64_t cpuCycles = 0;                                           // Instruction cycles without memory access wait states
+    };
+
+    /// @brief Count decoding work for a chunk by parsing its data
+    /// @param type Chunk type as stored in the chunk header
+    /// @param data Chunk data without the chunk header
+    /// @param uncompressedSize Size of data after decoding the chunk
+    auto countOperations(Image::ProcessingType type, const std::vector<uint8_t> &data, uint32_t uncompressedSize) -> Operations;
+
+    /// @brief Calculate cycles needed to decode a chunk read from src and written to dst
+    auto cycles(const Operations &operations, Region src, Region dst, const Setup &setup = Setup()) -> uint64_t;
+
+    /// @brief Decode estimate for a frame
+    struct FrameEstimate
+    {
+        uint64_t cycles = 0;   // Cycles needed to decode all chunks and copy the frame to the blit destination
+        bool supported = true; // False if any chunk can not be decoded by the player
+
+        auto seconds() const -> double
+        {
+            return static_cast<double>(cycles) / CyclesPerSecond;
+        }
+    };
+
+    /// @brief Estimate cycles needed to decode a frame like Video::decode and copy it to the screen like Video::decodeAndBlitFrame.
+    /// The first chunk is read from the frame source, all others from the scratch pad
+    /// @param chunks Chunk operations in the order the chunks were created (innermost chunk first)
+    /// @param frameSize Size of the frame data. Used if there are no chunks
+    auto estimateFrame(const std::vector<Operations> &chunks, uint32_t frameSize, const Setup &setup = Setup()) -> FrameEstimate;
+
+}
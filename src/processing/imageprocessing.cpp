@@ -4,13 +4,23 @@
 #include "codec/dxtv.h"
 #include "codec/gvid.h"
 #include "color/colorhelpers.h"
+#include "compression/huffman.h"
+#include "compression/lzinter.h"
 #include "compression/lzss.h"
+#include "compression/rans.h"
+#include "compression/rle.h"
 #include "datahelpers.h"
+#include "decodecost.h"
 #include "exception.h"
 #include "imagehelpers.h"
 #include "spritehelpers.h"
 
+#include <cmath>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <tuple>
 
 namespace Image
 {
@@ -32,7 +42,11 @@ namespace Image
             {ProcessingType::ConvertDelta16, {"delta-16", OperationType::Convert, FunctionType(toDelta16)}},
             {ProcessingType::CompressLz10, {"compress LZ10", OperationType::Convert, FunctionType(compressLZ10)}},
             {ProcessingType::CompressLz11, {"compress LZ11", OperationType::Convert, FunctionType(compressLZ11)}},
-            //{ProcessingType::CompressRLE, {"compress RLE", OperationType::Convert, FunctionType(compressRLE)}},
+            {ProcessingType::CompressRLE, {"compress RLE", OperationType::Convert, FunctionType(compressRLE)}},
+            {ProcessingType::CompressHuffman, {"compress Huffman", OperationType::Convert, FunctionType(compressHuffman)}},
+            {ProcessingType::CompressBest, {"compress best", OperationType::Convert, FunctionType(compressBest)}},
+            {ProcessingType::CompressRANS, {"compress rANS", OperationType::Convert, FunctionType(compressRANS)}},
+            {ProcessingType::CompressLzInter, {"compress LZ inter", OperationType::ConvertState, FunctionType(compressLzInter)}},
             {ProcessingType::CompressDXTG, {"compress DXTG", OperationType::Convert, FunctionType(compressDXTG)}},
             {ProcessingType::CompressDXTV, {"compress DXTV", OperationType::ConvertState, FunctionType(compressDXTV)}},
             {ProcessingType::CompressGVID, {"compress GVID", OperationType::ConvertState, FunctionType(compressGVID)}},
@@ -43,20 +57,20 @@ namespace Image
             {ProcessingType::EqualizeColorMaps, {"equalize color maps", OperationType::BatchConvert, FunctionType(equalizeColorMaps)}},
             {ProcessingType::DeltaImage, {"image diff", OperationType::ConvertState, FunctionType(imageDiff)}}};
 
+    const std::map<ProcessingType, Processing::RawInputFunc>
+        Processing::RawInputFunctions = {
+            {ProcessingType::InputBlackWhite, toBlackWhiteRaw},
+            {ProcessingType::InputTruecolor, toTruecolorRaw}};
+
     Data Processing::toBlackWhite(const Magick::Image &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
     {
-        // get parameter(s)
-        REQUIRE(parameters.size() == 1 && std::holds_alternative<double>(parameters.front()), std::runtime_error, "toBlackWhite expects a single double threshold parameter");
-        const auto threshold = std::get<double>(parameters.front());
-        REQUIRE(threshold >= 0 && threshold <= 1, std::runtime_error, "Threshold must be in [0.0, 1.0]");
-        // threshold image
+        // get RGB888 pixels and threshold them in the raw input path, so results are identical for both inputs
         Magick::Image temp = image;
-        temp.threshold(threshold);
-        temp.quantizeDither(false);
-        temp.quantizeColors(2);
-        temp.type(Magick::ImageType::PaletteType);
-        // get image data and color map
-        return {0, "", temp.type(), temp.classType(), image.size(), DataType::Bitmap, ColorFormat::Paletted8, {}, getImageData(temp), getColorMap(temp), ColorFormat::Unknown, {}};
+        const uint32_t width = temp.columns();
+        const uint32_t height = temp.rows();
+        std::vector<uint8_t> rgb888(static_cast<std::size_t>(width) * height * 3);
+        temp.write(0, 0, width, height, "RGB", Magick::StorageType::CharPixel, rgb888.data());
+        return toBlackWhiteRaw(rgb888.data(), width, height, parameters, statistics);
     }
 
     Data Processing::toPaletted(const Magick::Image &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
@@ -114,6 +128,65 @@ namespace Image
 
     // ----------------------------------------------------------------------------
 
+    Data Processing::toBlackWhiteRaw(const uint8_t *rgb888, uint32_t width, uint32_t height, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        // get parameter(s)
+        REQUIRE(parameters.size() == 1 && std::holds_alternative<double>(parameters.front()), std::runtime_error, "toBlackWhiteRaw expects a single double threshold parameter");
+        const auto threshold = std::get<double>(parameters.front());
+        REQUIRE(threshold >= 0 && threshold <= 1, std::runtime_error, "Threshold must be in [0.0, 1.0]");
+        // threshold pixels using Rec. 709 luma. color 0 is black, color 1 is white
+        const std::size_t nrOfPixels = width * height;
+        const double threshold255 = threshold * 255.0;
+        std::vector<uint8_t> data(nrOfPixels);
+        for (std::size_t i = 0; i < nrOfPixels; i++, rgb888 += 3)
+        {
+            const double intensity = 0.212656 * rgb888[0] + 0.715158 * rgb888[1] + 0.072186 * rgb888[2];
+            data[i] = intensity > threshold255 ? 1 : 0;
+        }
+        return {0, "", Magick::ImageType::PaletteType, Magick::ClassType::PseudoClass, Magick::Geometry(width, height), DataType::Bitmap, ColorFormat::Paletted8, {}, data, {Magick::ColorRGB(0, 0, 0), Magick::ColorRGB(1, 1, 1)}, ColorFormat::Unknown, {}};
+    }
+
+    Data Processing::toTruecolorRaw(const uint8_t *rgb888, uint32_t width, uint32_t height, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        // get parameter(s)
+        REQUIRE(parameters.size() == 1 && std::holds_alternative<std::string>(parameters.front()), std::runtime_error, "toTruecolorRaw expects a single std::string parameter");
+        const auto formatString = std::get<std::string>(parameters.front());
+        REQUIRE(formatString == "RGB888" || formatString == "RGB565" || formatString == "RGB555", std::runtime_error, "Color format must be in [RGB555, RGB565, RGB888]");
+        const std::size_t nrOfPixels = width * height;
+        // convert colors directly from input pixels. 16 bit colors are stored little-endian
+        std::vector<uint8_t> imageData;
+        ColorFormat format = ColorFormat::RGB888;
+        if (formatString == "RGB888")
+        {
+            imageData.assign(rgb888, rgb888 + nrOfPixels * 3);
+        }
+        else if (formatString == "RGB565")
+        {
+            format = ColorFormat::RGB565;
+            imageData.resize(nrOfPixels * 2);
+            for (std::size_t i = 0; i < nrOfPixels; i++, rgb888 += 3)
+            {
+                const uint16_t color = ((rgb888[0] >> 3) << 11) | ((rgb888[1] >> 2) << 5) | (rgb888[2] >> 3);
+                imageData[2 * i] = color & 0xFF;
+                imageData[2 * i + 1] = color >> 8;
+            }
+        }
+        else
+        {
+            format = ColorFormat::RGB555;
+            imageData.resize(nrOfPixels * 2);
+            for (std::size_t i = 0; i < nrOfPixels; i++, rgb888 += 3)
+            {
+                const uint16_t color = ((rgb888[0] >> 3) << 10) | ((rgb888[1] >> 3) << 5) | (rgb888[2] >> 3);
+                imageData[2 * i] = color & 0xFF;
+                imageData[2 * i + 1] = color >> 8;
+            }
+        }
+        return {0, "", Magick::ImageType::TrueColorType, Magick::ClassType::DirectClass, Magick::Geometry(width, height), DataType::Bitmap, format, {}, imageData, {}, ColorFormat::Unknown, {}};
+    }
+
+    // ----------------------------------------------------------------------------
+
     Data Processing::toUniqueTileMap(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
     {
         REQUIRE(image.dataType == DataType::Bitmap, std::runtime_error, "toUniqueTileMap expects bitmaps as input data");
@@ -271,37 +344,171 @@ namespace Image
 
     // ----------------------------------------------------------------------------
 
-    Data Processing::compressLZ10(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    /// @brief Compress image data using LZ77 variant 10 or 11, optionally in independent chunks
+    static Data compressLzssStep(const Data &image, const std::vector<Processing::Parameter> &parameters, bool lz11Compression)
     {
         // get parameter(s)
-        REQUIRE(parameters.size() == 1 && std::holds_alternative<bool>(parameters.front()), std::runtime_error, "compressLZ10 expects a single bool VRAMcompatible parameter");
-        const auto vramCompatible = std::get<bool>(parameters.front());
+        REQUIRE(parameters.size() >= 1 && parameters.size() <= 3 && std::holds_alternative<bool>(parameters.at(0)) && (parameters.size() < 2 || std::holds_alternative<bool>(parameters.at(1))) && (parameters.size() < 3 || std::holds_alternative<uint32_t>(parameters.at(2))), std::runtime_error, "compressLZ1" << (lz11Compression ? "1" : "0") << " expects a bool VRAMcompatible, an optional bool optimal parsing and an optional uint32_t chunk size parameter");
+        const auto vramCompatible = std::get<bool>(parameters.at(0));
+        const auto optimalParse = parameters.size() >= 2 && std::get<bool>(parameters.at(1));
+        const auto chunkSize = parameters.size() >= 3 ? std::get<uint32_t>(parameters.at(2)) : 0;
         // compress data
         auto result = image;
-        result.data = Compression::compressLzss(image.data, vramCompatible, false);
-        // result.data = LZSS::encodeLZSS(image.data, vramCompatible);
+        if (chunkSize > 0)
+        {
+            std::tie(result.data, result.compressedChunkOffsets) = Compression::compressLzssChunked(image.data, vramCompatible, lz11Compression, optimalParse, chunkSize);
+        }
+        else
+        {
+            result.data = Compression::compressLzss(image.data, vramCompatible, lz11Compression, optimalParse);
+            result.compressedChunkOffsets.clear();
+        }
         return result;
     }
 
+    Data Processing::compressLZ10(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        return compressLzssStep(image, parameters, false);
+    }
+
     Data Processing::compressLZ11(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        return compressLzssStep(image, parameters, true);
+    }
+
+    Data Processing::compressRLE(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
     {
         // get parameter(s)
-        REQUIRE(parameters.size() == 1 && std::holds_alternative<bool>(parameters.front()), std::runtime_error, "compressLZ11 expects a single bool VRAMcompatible parameter");
+        REQUIRE(parameters.size() == 1 && std::holds_alternative<bool>(parameters.front()), std::runtime_error, "compressRLE expects a single bool VRAMcompatible parameter");
         const auto vramCompatible = std::get<bool>(parameters.front());
         // compress data
         auto result = image;
-        result.data = Compression::compressLzss(image.data, vramCompatible, true);
+        result.data = Compression::compressRle(image.data, vramCompatible);
         return result;
     }
 
-    Data Processing::compressRLE(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    Data Processing::compressHuffman(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
     {
         // get parameter(s)
-        REQUIRE(parameters.size() == 1 && std::holds_alternative<bool>(parameters.front()), std::runtime_error, "compressRLE expects a single bool VRAMcompatible parameter");
-        const auto vramCompatible = std::get<bool>(parameters.front());
+        REQUIRE(parameters.size() == 1 && std::holds_alternative<uint32_t>(parameters.front()), std::runtime_error, "compressHuffman expects a single uint32_t bits per symbol parameter");
+        const auto bitsPerSymbol = std::get<uint32_t>(parameters.front());
+        REQUIRE(bitsPerSymbol == 4 || bitsPerSymbol == 8, std::runtime_error, "Bits per symbol must be 4 or 8");
         // compress data
         auto result = image;
-        // result.data = RLE::encodeRLE(image.data, vramCompatible);
+        result.data = Compression::compressHuffman(image.data, bitsPerSymbol);
+        return result;
+    }
+
+    Data Processing::compressRANS(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        auto result = image;
+        result.data = Compression::compressRans(image.data);
+        REQUIRE(Compression::decompressRans(result.data) == image.data, std::runtime_error, "rANS compression verification failed");
+        return result;
+    }
+
+    Data Processing::compressLzInter(const Data &image, const std::vector<Parameter> &parameters, std::vector<uint8_t> &state, Statistics::Container::SPtr statistics)
+    {
+        // compress against previous image data. state is empty for the first image
+        auto result = image;
+        result.data = Compression::compressLzInter(image.data, state);
+        REQUIRE(Compression::decompressLzInter(result.data, state) == image.data, std::runtime_error, "LZ inter-frame compression verification failed");
+        if (statistics != nullptr)
+        {
+            statistics->addValue("LZ inter ratio", static_cast<double>(result.data.size()) / static_cast<double>(std::max(image.data.size(), std::size_t(1))));
+        }
+        // set current image to state
+        state = image.data;
+        return result;
+    }
+
+    Data Processing::compressBest(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics)
+    {
+        // get parameter(s)
+        REQUIRE(parameters.size() == 3 && std::holds_alternative<bool>(parameters.at(0)) && std::holds_alternative<bool>(parameters.at(1)) && std::holds_alternative<double>(parameters.at(2)), std::runtime_error, "compressBest expects bool VRAMcompatible, bool optimal LZ parsing and double size tolerance parameters");
+        const auto vramCompatible = std::get<bool>(parameters.at(0));
+        const auto optimalParse = std::get<bool>(parameters.at(1));
+        const auto sizeTolerance = std::get<double>(parameters.at(2));
+        REQUIRE(sizeTolerance >= 0 && sizeTolerance <= 1, std::runtime_error, "Size tolerance must be in [0,1]");
+        // candidates. LZ11 is not supported by the GBA BIOS, so we don't try it
+        const std::vector<ProcessingType> types = {ProcessingType::Uncompressed, ProcessingType::CompressRLE, ProcessingType::CompressLz10, ProcessingType::CompressHuffman};
+        std::vector<std::vector<uint8_t>> results(types.size());
+        std::vector<uint8_t> valid(types.size(), 0); // no std::vector<bool>. threads write to separate elements
+        std::vector<std::exception_ptr> errors(types.size());
+#pragma omp parallel for
+        for (int ti = 0; ti < static_cast<int>(types.size()); ti++)
+        {
+            try
+            {
+                switch (types[ti])
+                {
+                case ProcessingType::Uncompressed:
+                    // the decoder copies uncompressed data in 32-bit units
+                    if (image.data.size() % 4 == 0)
+                    {
+                        results[ti] = image.data;
+                        valid[ti] = 1;
+                    }
+                    break;
+                case ProcessingType::CompressRLE:
+                    if (!vramCompatible || image.data.size() % 2 == 0)
+                    {
+                        results[ti] = Compression::compressRle(image.data, vramCompatible);
+                        valid[ti] = 1;
+                    }
+                    break;
+                case ProcessingType::CompressLz10:
+                    results[ti] = Compression::compressLzss(image.data, vramCompatible, false, optimalParse);
+                    valid[ti] = 1;
+                    break;
+                case ProcessingType::CompressHuffman:
+                    results[ti] = Compression::compressHuffman(image.data, 8);
+                    valid[ti] = 1;
+                    break;
+                default:
+                    break;
+                }
+            }
+            catch (...)
+            {
+                errors[ti] = std::current_exception();
+            }
+        }
+        auto errorIt = std::find_if(errors.cbegin(), errors.cend(), [](const auto &e)
+                                    { return e != nullptr; });
+        if (errorIt != errors.cend())
+        {
+            std::rethrow_exception(*errorIt);
+        }
+        // find smallest result, then the result that is small enough and has the lowest estimated decode time
+        std::size_t minSize = std::numeric_limits<std::size_t>::max();
+        for (std::size_t ti = 0; ti < types.size(); ti++)
+        {
+            minSize = valid[ti] && results[ti].size() < minSize ? results[ti].size() : minSize;
+        }
+        const auto maxSize = static_cast<std::size_t>(std::floor(minSize * (1 + sizeTolerance)));
+        std::size_t chosen = types.size();
+        uint64_t chosenCycles = std::numeric_limits<uint64_t>::max();
+        for (std::size_t ti = 0; ti < types.size(); ti++)
+        {
+            if (valid[ti] && results[ti].size() <= maxSize)
+            {
+                // estimate decode time for data read from ROM into the scratch pad. on equal time the earlier type wins
+                const auto cycles = DecodeCost::cycles(DecodeCost::countOperations(types[ti], results[ti], image.data.size()), DecodeCost::Region::ROM, DecodeCost::Region::EWRAM);
+                if (cycles < chosenCycles)
+                {
+                    chosen = ti;
+                    chosenCycles = cycles;
+                }
+            }
+        }
+        auto result = image;
+        result.data = std::move(results[chosen]);
+        result.encodedType = types[chosen];
+        if (statistics != nullptr)
+        {
+            statistics->addValue("compress best type", static_cast<double>(types[chosen]));
+        }
         return result;
     }
 
@@ -311,6 +518,9 @@ namespace Image
         REQUIRE(image.colorFormat == ColorFormat::RGB888 || image.colorFormat == ColorFormat::RGB555, std::runtime_error, "DXTG compression is only possible for RGB888 and RGB555 truecolor images");
         REQUIRE(image.size.width() % 4 == 0, std::runtime_error, "Image width must be a multiple of 4 for DXT compression");
         REQUIRE(image.size.height() % 4 == 0, std::runtime_error, "Image height must be a multiple of 4 for DXT compression");
+        // get parameter(s)
+        REQUIRE(parameters.empty() || (parameters.size() == 1 && std::holds_alternative<bool>(parameters.front())), std::runtime_error, "compressDXTG expects an optional bool cluster fit parameter");
+        const auto clusterFit = !parameters.empty() && std::get<bool>(parameters.front());
         // convert RGB888 to RGB565
         auto data = image.data;
         if (image.colorFormat == ColorFormat::RGB888)
@@ -320,7 +530,7 @@ namespace Image
         auto result = image;
         result.colorFormat = ColorFormat::RGB555;
         result.mapData = {};
-        result.data = DXT::encodeDXTG(convertTo<uint16_t>(data), image.size.width(), image.size.height());
+        result.data = DXT::encodeDXTG(convertTo<uint16_t>(data), image.size.width(), image.size.height(), clusterFit);
         result.colorMap = {};
         result.colorMapFormat = ColorFormat::Unknown;
         result.colorMapData = {};
@@ -334,13 +544,15 @@ namespace Image
         REQUIRE(image.size.width() % 16 == 0, std::runtime_error, "Image width must be a multiple of 16 for DXT compression");
         REQUIRE(image.size.height() % 16 == 0, std::runtime_error, "Image height must be a multiple of 16 for DXT compression");
         // get parameter(s)
-        REQUIRE(parameters.size() == 2, std::runtime_error, "compressDXTV expects 2 double parameters");
+        REQUIRE(parameters.size() == 2 || parameters.size() == 3, std::runtime_error, "compressDXTV expects 2 double parameters and an optional bool cluster fit parameter");
         REQUIRE(std::holds_alternative<double>(parameters.at(0)), std::runtime_error, "compressDXTV keyframe interval must be a double");
         auto keyFrameInterval = static_cast<int32_t>(std::get<double>(parameters.at(0)));
         REQUIRE(keyFrameInterval >= 0 && keyFrameInterval <= 60, std::runtime_error, "compressDXTV keyframe interval must be in [0,60] (0 = none)");
         REQUIRE(std::holds_alternative<double>(parameters.at(1)), std::runtime_error, "compressDXTV max. block error must be a double");
         auto maxBlockError = std::get<double>(parameters.at(1));
         REQUIRE(maxBlockError >= 0.01 && maxBlockError <= 1, std::runtime_error, "compressDXTV max. block error must be in [0.01,1]");
+        REQUIRE(parameters.size() < 3 || std::holds_alternative<bool>(parameters.at(2)), std::runtime_error, "compressDXTV cluster fit flag must be a bool");
+        const auto clusterFit = parameters.size() >= 3 && std::get<bool>(parameters.at(2));
         // convert RGB888 to RGB555
         auto data = image.data;
         if (image.colorFormat == ColorFormat::RGB888)
@@ -353,7 +565,7 @@ namespace Image
         auto result = image;
         result.colorFormat = ColorFormat::RGB555;
         result.mapData = {};
-        auto dxtData = DXTV::encodeDXTV(convertTo<uint16_t>(data), state.empty() ? std::vector<uint16_t>() : convertTo<uint16_t>(state), image.size.width(), image.size.height(), isKeyFrame, maxBlockError);
+        auto dxtData = DXTV::encodeDXTV(convertTo<uint16_t>(data), state.empty() ? std::vector<uint16_t>() : convertTo<uint16_t>(state), image.size.width(), image.size.height(), isKeyFrame, maxBlockError, clusterFit);
         result.data = dxtData.first;
         result.colorMap = {};
         result.colorMapFormat = ColorFormat::Unknown;
@@ -496,6 +708,16 @@ namespace Image
         m_statistics = c;
     }
 
+    void Processing::addTiming(std::size_t stepIndex, const std::chrono::steady_clock::time_point &startTime, uint64_t bytesIn, uint64_t bytesOut, uint64_t calls) const
+    {
+        if (m_statistics)
+        {
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+            const auto &stepFunc = ProcessingFunctions.find(m_steps[stepIndex].type)->second;
+            m_statistics->addTiming(static_cast<uint32_t>(stepIndex), stepFunc.description, duration.count(), bytesIn, bytesOut, calls);
+        }
+    }
+
     void Processing::addStep(ProcessingType type, const std::vector<Parameter> &parameters, bool prependProcessing, bool addStatistics)
     {
         m_steps.push_back({type, parameters, prependProcessing, addStatistics});
@@ -549,9 +771,13 @@ namespace Image
     {
         REQUIRE(img.data.size() < (1 << 24), std::runtime_error, "Data size stored must be < 16MB");
         REQUIRE(static_cast<uint32_t>(type) <= 127, std::runtime_error, "Type value must be <= 127");
-        const uint32_t sizeAndType = ((size & 0xFFFFFF) << 8) | ((static_cast<uint32_t>(type) & 0x7F) | (isFinal ? static_cast<uint32_t>(ProcessingTypeFinal) : 0));
+        // steps that choose their encoding per image store the type they chose
+        const auto storedType = img.encodedType.value_or(type);
+        const uint32_t sizeAndType = ((size & 0xFFFFFF) << 8) | ((static_cast<uint32_t>(storedType) & 0x7F) | (isFinal ? static_cast<uint32_t>(ProcessingTypeFinal) : 0));
         auto result = img;
         result.data = prependValue(img.data, sizeAndType);
+        // count decoding work while the chunk data is at hand
+        result.decodeOperations.push_back(DecodeCost::countOperations(storedType, img.data, size));
         return result;
     }
 
@@ -562,10 +788,18 @@ namespace Image
         std::vector<Data> processed = data;
         std::for_each(processed.begin(), processed.end(), [index = 0](auto &p) mutable
                       { p.index = index++; });
+        auto dataSize = [](const std::vector<Data> &images)
+        {
+            return std::accumulate(images.cbegin(), images.cend(), uint64_t(0), [](auto sum, const auto &img)
+                                   { return sum + img.data.size(); });
+        };
         for (auto stepIt = m_steps.begin(); stepIt != m_steps.end(); ++stepIt)
         {
             auto stepStatistics = stepIt->addStatistics ? m_statistics : nullptr;
             auto &stepFunc = ProcessingFunctions.find(stepIt->type)->second;
+            const auto stepStartTime = std::chrono::steady_clock::now();
+            const auto stepInputSize = dataSize(processed);
+            const auto stepInputCount = processed.size();
             // check if this was the final processing step (first non-input processing)
             bool isFinalStep = false;
             if (!finalStepFound)
@@ -576,18 +810,39 @@ namespace Image
             // we're silently ignoring OperationType::Input operations here
             if (stepFunc.type == OperationType::Convert)
             {
+                // images are independent of each other, so convert them in parallel. image sizes and thus compression times
+                // can vary a lot, so hand out images one by one. every image writes only to its own slot, so the result does
+                // not depend on the number of threads or the order images are processed in
                 auto convertFunc = std::get<ConvertFunc>(stepFunc.func);
-                for (auto &img : processed)
+                std::vector<std::exception_ptr> errors(processed.size());
+#pragma omp parallel for schedule(dynamic, 1)
+                for (int i = 0; i < static_cast<int>(processed.size()); i++)
                 {
-                    const uint32_t inputSize = img.data.size();
-                    img = convertFunc(img, stepIt->parameters, stepStatistics);
-                    if (stepIt->prependProcessing)
+                    try
                     {
-                        img = prependProcessing(img, static_cast<uint32_t>(inputSize), stepIt->type, isFinalStep);
+                        auto &img = processed[i];
+                        const uint32_t inputSize = img.data.size();
+                        img = convertFunc(img, stepIt->parameters, stepStatistics);
+                        if (stepIt->prependProcessing)
+                        {
+                            img = prependProcessing(img, static_cast<uint32_t>(inputSize), stepIt->type, isFinalStep);
+                        }
+                        img.encodedType.reset();
+                        // record max. memory needed for everything, but the first step
+                        auto chunkMemoryNeeded = img.data.size() + sizeof(uint32_t);
+                        img.maxMemoryNeeded = (stepFunc.type != OperationType::Input && img.maxMemoryNeeded < chunkMemoryNeeded) ? chunkMemoryNeeded : img.maxMemoryNeeded;
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
                     }
-                    // record max. memory needed for everything, but the first step
-                    auto chunkMemoryNeeded = img.data.size() + sizeof(uint32_t);
-                    img.maxMemoryNeeded = (stepFunc.type != OperationType::Input && img.maxMemoryNeeded < chunkMemoryNeeded) ? chunkMemoryNeeded : img.maxMemoryNeeded;
+                }
+                // exceptions can not leave an OpenMP region. re-throw the error of the first failing image
+                auto errorIt = std::find_if(errors.cbegin(), errors.cend(), [](const auto &e)
+                                            { return e != nullptr; });
+                if (errorIt != errors.cend())
+                {
+                    std::rethrow_exception(*errorIt);
                 }
             }
             else if (stepFunc.type == OperationType::ConvertState)
@@ -601,6 +856,7 @@ namespace Image
                     {
                         img = prependProcessing(img, static_cast<uint32_t>(inputSize), stepIt->type, isFinalStep);
                     }
+                    img.encodedType.reset();
                     // record max. memory needed for everything, but the first step
                     auto chunkMemoryNeeded = img.data.size() + sizeof(uint32_t);
                     img.maxMemoryNeeded = (stepFunc.type != OperationType::Input && img.maxMemoryNeeded < chunkMemoryNeeded) ? chunkMemoryNeeded : img.maxMemoryNeeded;
@@ -621,6 +877,7 @@ namespace Image
                         const uint32_t inputSize = inputSizes.at(std::distance(processed.begin(), pIt));
                         *pIt = prependProcessing(*pIt, static_cast<uint32_t>(inputSize), stepIt->type, isFinalStep);
                     }
+                    pIt->encodedType.reset();
                     // record max. memory needed for everything, but the first step
                     auto chunkMemoryNeeded = pIt->data.size() + sizeof(uint32_t);
                     pIt->maxMemoryNeeded = (stepFunc.type != OperationType::Input && pIt->maxMemoryNeeded < chunkMemoryNeeded) ? chunkMemoryNeeded : pIt->maxMemoryNeeded;
@@ -631,51 +888,122 @@ namespace Image
                 auto reduceFunc = std::get<ReduceFunc>(stepFunc.func);
                 processed = {reduceFunc(processed, stepIt->parameters, stepStatistics)};
             }
+            if (stepFunc.type != OperationType::Input)
+            {
+                addTiming(std::distance(m_steps.begin(), stepIt), stepStartTime, stepInputSize, dataSize(processed), stepInputCount);
+            }
         }
         return processed;
     }
 
-    Data Processing::processStream(const Magick::Image &image, uint32_t index)
+    std::vector<Processing::StepRange> Processing::getStreamStages() const
+    {
+        auto isInput = [](const ProcessingStep &step)
+        { return ProcessingFunctions.find(step.type)->second.type == OperationType::Input; };
+        auto hasState = [](const ProcessingStep &step)
+        { return ProcessingFunctions.find(step.type)->second.type == OperationType::ConvertState; };
+        // find end of input steps, first and last step with state
+        const std::size_t inputEnd = std::distance(m_steps.cbegin(), std::find_if_not(m_steps.cbegin(), m_steps.cend(), isInput));
+        const auto firstStateIt = std::find_if(std::next(m_steps.cbegin(), inputEnd), m_steps.cend(), hasState);
+        const std::size_t stateBegin = std::distance(m_steps.cbegin(), firstStateIt);
+        const std::size_t stateEnd = firstStateIt == m_steps.cend() ? stateBegin : std::distance(m_steps.cbegin(), std::find_if(m_steps.crbegin(), m_steps.crend(), hasState).base());
+        // build stages, omitting empty ranges
+        std::vector<StepRange> result;
+        for (const auto &range : {StepRange(0, inputEnd), StepRange(inputEnd, stateBegin), StepRange(stateBegin, stateEnd), StepRange(stateEnd, m_steps.size())})
+        {
+            if (range.first < range.second)
+            {
+                result.push_back(range);
+            }
+        }
+        return result;
+    }
+
+    bool Processing::hasState(const StepRange &steps) const
     {
-        REQUIRE(ProcessingFunctions.find(m_steps.front().type)->second.type == OperationType::Input, std::runtime_error, "First step must be an input step");
-        bool finalStepFound = false;
-        Data processed;
-        for (auto stepIt = m_steps.begin(); stepIt != m_steps.end(); ++stepIt)
+        const auto lastStep = std::min(steps.second, m_steps.size());
+        for (auto si = steps.first; si < lastStep; si++)
         {
-            const uint32_t inputSize = processed.data.size();
-            auto stepStatistics = stepIt->addStatistics ? m_statistics : nullptr;
-            auto &stepFunc = ProcessingFunctions.find(stepIt->type)->second;
-            if (stepFunc.type == OperationType::Input)
+            if (ProcessingFunctions.find(m_steps[si].type)->second.type == OperationType::ConvertState)
             {
-                auto inputFunc = std::get<InputFunc>(stepFunc.func);
-                processed = inputFunc(image, stepIt->parameters, stepStatistics);
-                processed.index = index;
+                return true;
             }
-            else if (stepFunc.type == OperationType::Convert)
+        }
+        return false;
+    }
+
+    Data Processing::processStream(const Magick::Image &image, uint32_t index, StepRange steps)
+    {
+        steps.second = std::min(steps.second, m_steps.size());
+        REQUIRE(steps.first < steps.second, std::runtime_error, "Empty step range passed");
+        const auto &inputStep = m_steps.at(steps.first);
+        const auto &inputStepFunc = ProcessingFunctions.find(inputStep.type)->second;
+        REQUIRE(inputStepFunc.type == OperationType::Input, std::runtime_error, "First step must be an input step");
+        auto inputFunc = std::get<InputFunc>(inputStepFunc.func);
+        const auto startTime = std::chrono::steady_clock::now();
+        Data processed = inputFunc(image, inputStep.parameters, inputStep.addStatistics ? m_statistics : nullptr);
+        addTiming(steps.first, startTime, static_cast<uint64_t>(image.columns()) * image.rows() * 3, processed.data.size());
+        processed.index = index;
+        return processStream(processed, {steps.first + 1, steps.second});
+    }
+
+    Data Processing::processStream(const uint8_t *rgb888, uint32_t width, uint32_t height, uint32_t index, StepRange steps)
+    {
+        REQUIRE(rgb888 != nullptr, std::runtime_error, "No pixel data passed");
+        steps.second = std::min(steps.second, m_steps.size());
+        REQUIRE(steps.first < steps.second, std::runtime_error, "Empty step range passed");
+        const auto &inputStep = m_steps.at(steps.first);
+        const auto rawInputIt = RawInputFunctions.find(inputStep.type);
+        if (rawInputIt == RawInputFunctions.cend())
+        {
+            // no native input step. build image and use ImageMagick
+            return processStream(Magick::Image(width, height, "RGB", Magick::StorageType::CharPixel, rgb888), index, steps);
+        }
+        const auto startTime = std::chrono::steady_clock::now();
+        Data processed = rawInputIt->second(rgb888, width, height, inputStep.parameters, inputStep.addStatistics ? m_statistics : nullptr);
+        addTiming(steps.first, startTime, static_cast<uint64_t>(width) * height * 3, processed.data.size());
+        processed.index = index;
+        return processStream(processed, {steps.first + 1, steps.second});
+    }
+
+    Data Processing::processStream(const Data &data, StepRange steps)
+    {
+        steps.second = std::min(steps.second, m_steps.size());
+        // the final processing step is the first non-input processing step in the whole pipeline
+        const std::size_t finalStepIndex = std::distance(m_steps.cbegin(), std::find_if(m_steps.cbegin(), m_steps.cend(), [](const auto &step)
+                                                                                         { return ProcessingFunctions.find(step.type)->second.type != OperationType::Input; }));
+        Data processed = data;
+        for (auto si = steps.first; si < steps.second; si++)
+        {
+            auto &step = m_steps[si];
+            const uint32_t inputSize = processed.data.size();
+            auto stepStatistics = step.addStatistics ? m_statistics : nullptr;
+            auto &stepFunc = ProcessingFunctions.find(step.type)->second;
+            const auto startTime = std::chrono::steady_clock::now();
+            // we're silently ignoring OperationType::Input, ::BatchConvert and ::Reduce operations here
+            if (stepFunc.type == OperationType::Convert)
             {
                 auto convertFunc = std::get<ConvertFunc>(stepFunc.func);
-                processed = convertFunc(processed, stepIt->parameters, stepStatistics);
+                processed = convertFunc(processed, step.parameters, stepStatistics);
             }
             else if (stepFunc.type == OperationType::ConvertState)
             {
                 auto convertFunc = std::get<ConvertStateFunc>(stepFunc.func);
-                processed = convertFunc(processed, stepIt->parameters, stepIt->state, stepStatistics);
+                processed = convertFunc(processed, step.parameters, step.state, stepStatistics);
             }
-            // check if this was the final processing step (first non-input processing)
-            bool isFinalStep = false;
-            if (!finalStepFound)
+            else
             {
-                isFinalStep = stepFunc.type != OperationType::Input;
-                finalStepFound = isFinalStep;
+                continue;
             }
-            // we're silently ignoring OperationType::BatchConvert and ::Reduce operations here
-            if (stepIt->prependProcessing)
+            if (step.prependProcessing)
             {
-                processed = prependProcessing(processed, static_cast<uint32_t>(inputSize), stepIt->type, isFinalStep);
+                processed = prependProcessing(processed, static_cast<uint32_t>(inputSize), step.type, si == finalStepIndex);
             }
+            processed.encodedType.reset();
             // record max. memory needed for everything, but the first step
             auto chunkMemoryNeeded = processed.data.size() + sizeof(uint32_t);
-            processed.maxMemoryNeeded = (stepFunc.type != OperationType::Input && processed.maxMemoryNeeded < chunkMemoryNeeded) ? chunkMemoryNeeded : processed.maxMemoryNeeded;
+            processed.maxMemoryNeeded = processed.maxMemoryNeeded < chunkMemoryNeeded ? chunkMemoryNeeded : processed.maxMemoryNeeded;
+            addTiming(si, startTime, inputSize, processed.data.size());
         }
         return processed;
     }
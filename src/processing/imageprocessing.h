@@ -8,7 +8,10 @@
 
 #include <Magick++.h>
 
+#include <chrono>
 #include <cstdint>
+#include <limits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -21,7 +24,8 @@ namespace Image
         /// @brief Variable parameters for processing step
         using Parameter = std::variant<bool, int32_t, uint32_t, double, Magick::Color, Magick::Image, ColorFormat, Data, std::string>;
 
-        /// @brief Set object to receive statistics from processing pipeline
+        /// @brief Set object to receive statistics from processing pipeline.
+        /// Run time and data sizes of all processing steps will be recorded to the container too
         void setStatisticsContainer(Statistics::Container::SPtr c);
 
         /// @brief Add a processing step and its parameters
@@ -48,11 +52,42 @@ namespace Image
         /// @note Will silently ignore OperationType::Input operations
         std::vector<Data> processBatch(const std::vector<Data> &images);
 
+        /// @brief Range of processing steps [first, second) in pipeline
+        using StepRange = std::pair<std::size_t, std::size_t>;
+
+        /// @brief Range covering all processing steps in pipeline
+        static constexpr StepRange AllSteps = {0, std::numeric_limits<std::size_t>::max()};
+
+        /// @brief Split processing steps into consecutive ranges that can be run by separate threads in a streaming pipeline:
+        /// Input steps, stateless steps, steps up to and including the last OperationType::ConvertState step and the remaining stateless steps.
+        /// Empty ranges are omitted. Every range must see the images in stream order, so run each range on a single thread
+        std::vector<StepRange> getStreamStages() const;
+
+        /// @brief Check if any processing step in range has state (OperationType::ConvertState), so the images must pass through it in stream order
+        bool hasState(const StepRange &steps) const;
+
         /// @brief Run processing steps in pipeline on single image. Used for processing a stream of images / video frames
         /// @param image Input image
         /// @param index Image index in stream
+        /// @param steps Range of processing steps to run. The first step in range must be an input step
+        /// @note Will silently ignore OperationType::BatchConvert and ::Reduce operations
+        Data processStream(const Magick::Image &image, uint32_t index = 0, StepRange steps = AllSteps);
+
+        /// @brief Run processing steps in pipeline on single image stored as raw RGB888 pixels, e.g. a video frame.
+        /// Input steps that have a native raw pixel variant (see RawInputFunctions) will not create a Magick::Image, others fall back to it
+        /// @param rgb888 RGB888 pixel data, width * height * 3 bytes
+        /// @param width Image width in pixels
+        /// @param height Image height in pixels
+        /// @param index Image index in stream
+        /// @param steps Range of processing steps to run. The first step in range must be an input step
         /// @note Will silently ignore OperationType::BatchConvert and ::Reduce operations
-        Data processStream(const Magick::Image &image, uint32_t index = 0);
+        Data processStream(const uint8_t *rgb888, uint32_t width, uint32_t height, uint32_t index = 0, StepRange steps = AllSteps);
+
+        /// @brief Run processing steps in pipeline on data from a previous processStream() call. Used for splitting stream processing into multiple stages
+        /// @param data Input data
+        /// @param steps Range of processing steps to run
+        /// @note Will silently ignore OperationType::Input, ::BatchConvert and ::Reduce operations
+        Data processStream(const Data &data, StepRange steps);
 
         // --- image conversion functions ------------------------------------
 
@@ -71,6 +106,16 @@ namespace Image
         /// @param parameters Truecolor format to convert image to as std::string
         static Data toTruecolor(const Magick::Image &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
 
+        // --- raw pixel input functions ------------------------------------
+
+        /// @brief Binarize RGB888 pixels using threshold on Rec. 709 luma. Everything < threshold will be black (index #0) everything > threshold white (index #1)
+        /// @param parameters Binarization threshold as double. Must be in [0.0, 1.0]
+        static Data toBlackWhiteRaw(const uint8_t *rgb888, uint32_t width, uint32_t height, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
+
+        /// @brief Convert RGB888 pixels to RGB55, RGB565 or RGB888. Same result as toTruecolor()
+        /// @param parameters Truecolor format to convert image to as std::string
+        static Data toTruecolorRaw(const uint8_t *rgb888, uint32_t width, uint32_t height, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
+
         // --- data conversion functions ------------------------------------
 
         /// @brief Store optimized tile and screen map. Only max. 1024 unique tiles allowed!
@@ -123,11 +168,17 @@ namespace Image
         /// @brief Compress image data using LZ77 variant 10
         /// @param parameters:
         /// - Flag for VRAM-compatible compression as bool. Pass true to turn on
+        /// - Optional flag for optimal parsing as bool. Pass true for smallest output
+        /// - Optional chunk size in bytes as uint32_t. If > 0 the data is split into chunks that are compressed independently and in parallel.
+        ///   Chunk offsets are stored in Data::compressedChunkOffsets
         static Data compressLZ10(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
 
         /// @brief Compress image data using LZ77 variant 11
         /// @param parameters:
         /// - Flag for VRAM-compatible compression as bool. Pass true to turn on
+        /// - Optional flag for optimal parsing as bool. Pass true for smallest output
+        /// - Optional chunk size in bytes as uint32_t. If > 0 the data is split into chunks that are compressed independently and in parallel.
+        ///   Chunk offsets are stored in Data::compressedChunkOffsets
         static Data compressLZ11(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
 
         /// @brief Compress image data using RLE
@@ -135,8 +186,31 @@ namespace Image
         /// - Flag for VRAM-compatible compression as bool. Pass true to turn on
         static Data compressRLE(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
 
-        /// @brief Encode a truecolor RGB888 or RGB555 image as DXT1-ish image with RGB555 pixels
+        /// @brief Compress image data using Huffman encoding
+        /// @param parameters:
+        /// - Bits per symbol as uint32_t. Must be 4 or 8
+        static Data compressHuffman(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
+
+        /// @brief Compress image data using rANS entropy coding. The output is verified by decompressing it again
         /// @param parameters: Unused
+        static Data compressRANS(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
+
+        /// @brief Compress image data using LZ77 with matches into the previous image data. The output is verified by decompressing it again
+        /// @param parameters: Unused
+        /// @param state Previous image data
+        static Data compressLzInter(const Data &image, const std::vector<Parameter> &parameters, std::vector<uint8_t> &state, Statistics::Container::SPtr statistics);
+
+        /// @brief Compress image data using uncompressed storage, RLE, LZ10 and 8-bit Huffman in parallel and keep the result that is
+        /// fastest to decode according to DecodeCost, but at most sizeTolerance bigger than the smallest result. The type chosen is stored in Data::encodedType
+        /// @param parameters:
+        /// - Flag for VRAM-compatible compression as bool. Pass true to turn on
+        /// - Flag for optimal LZ parsing as bool. Pass true for smallest LZ output
+        /// - Size tolerance as double in [0,1]. 0 = always keep the smallest result, 0.1 = accept results up to 10% bigger that decode faster
+        static Data compressBest(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
+
+        /// @brief Encode a truecolor RGB888 or RGB555 image as DXT1-ish image with RGB555 pixels
+        /// @param parameters:
+        /// - Optional flag for cluster fit as bool. Pass true for higher quality, but slower encoding
         static Data compressDXTG(const Data &image, const std::vector<Parameter> &parameters, Statistics::Container::SPtr statistics);
 
         /// @brief Encode a truecolor RGB888 or RGB555 image as DXT1-ish image with RGB555 pixels
@@ -145,6 +219,7 @@ namespace Image
         /// - Key frame interval n as int in [1,20] meaning a key frame is stored every n frames
         /// - Maximum error for B-frame references (keyframes)
         /// - Maximum error for P-frame references (inter-frames)
+        /// - Optional flag for cluster fit as bool. Pass true for higher quality, but slower encoding
         /// @param state Previous image as Data
         static Data compressDXTV(const Data &image, const std::vector<Parameter> &parameters, std::vector<uint8_t> &state, Statistics::Container::SPtr statistics);
 
@@ -236,6 +311,9 @@ namespace Image
         std::vector<ProcessingStep> m_steps;
         Statistics::Container::SPtr m_statistics;
 
+        /// @brief Add run time since startTime and data sizes of call(s) to processing step to statistics container, if set
+        void addTiming(std::size_t stepIndex, const std::chrono::steady_clock::time_point &startTime, uint64_t bytesIn, uint64_t bytesOut, uint64_t calls = 1) const;
+
         enum class OperationType
         {
             Input,        // Converts image input into 1 data output
@@ -259,6 +337,10 @@ namespace Image
             FunctionType func;
         };
         static const std::map<ProcessingType, ProcessingFunc> ProcessingFunctions;
+
+        using RawInputFunc = std::function<Data(const uint8_t *, uint32_t, uint32_t, const std::vector<Parameter> &, Statistics::Container::SPtr statistics)>;
+        /// @brief Input steps that can work on raw RGB888 pixels directly instead of a Magick::Image
+        static const std::map<ProcessingType, RawInputFunc> RawInputFunctions;
     };
 
 }
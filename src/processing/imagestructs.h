@@ -1,10 +1,13 @@
 #pragma once
 
 #include "datahelpers.h"
+#include "decodecost.h"
 #include "exception.h"
+#include "processingtypes.h"
 
 #include <Magick++.h>
 #include <cstdint>
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -54,6 +57,9 @@ namespace Image
         ColorFormat colorMapFormat = ColorFormat::Unknown;               // raw color map data format
         std::vector<uint8_t> colorMapData;                               // raw color map data
         uint32_t maxMemoryNeeded = 0;                                    // max. intermediate memory needed to process the image. 0 if it can be directly written to destination (single processing stage)
+        std::optional<ProcessingType> encodedType;                       // processing type chosen by the last step, if it chooses its encoding per image. Stored in the chunk header instead of the step type
+        std::vector<DecodeCost::Operations> decodeOperations;            // work needed to decode the data chunks on the GBA, in order of creation
+        std::vector<uint32_t> compressedChunkOffsets;                    // byte offsets of independently compressed chunks in data, if the last compression step split the data
     };
 
     /// @brief Return true if the data has a color map, false if not.
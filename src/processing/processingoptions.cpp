@@ -183,14 +183,68 @@ ProcessingOptions::Option ProcessingOptions::lz11{
     false,
     {"lz11", "Use LZ compression variant 11.", cxxopts::value(lz11.isSet)}};
 
-/*ProcessingOptions::Option ProcessingOptions::rle{
+ProcessingOptions::Option ProcessingOptions::rle{
     false,
-    {"rle", "Use RLE compression.", cxxopts::value(rle.isSet)}};*/
+    {"rle", "Use RLE compression.", cxxopts::value(rle.isSet)}};
+
+ProcessingOptions::OptionT<uint32_t> ProcessingOptions::huffman{
+    false,
+    {"huffman", "Use Huffman compression. Parameter is the symbol size in bits, 4 or 8, e.g. \"--huffman=8\".", cxxopts::value(huffman.value)},
+    8,
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(huffman.cxxOption.opts_))
+        {
+            REQUIRE(huffman.value == 4 || huffman.value == 8, std::runtime_error, "Huffman symbol size must be 4 or 8");
+            huffman.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<double> ProcessingOptions::compressBest{
+    false,
+    {"compressbest", "Try uncompressed, RLE, LZ10 and Huffman compression per frame and keep the result fastest to decode that is at most TOLERANCE in [0,1] bigger than the smallest result, e.g. \"--compressbest=0.05\".", cxxopts::value(compressBest.value)},
+    0,
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(compressBest.cxxOption.opts_))
+        {
+            REQUIRE(compressBest.value >= 0 && compressBest.value <= 1, std::runtime_error, "Size tolerance must be in [0,1]");
+            compressBest.isSet = true;
+        }
+    }};
 
 ProcessingOptions::Option ProcessingOptions::vram{
     false,
     {"vram", "Make compression VRAM-safe.", cxxopts::value(vram.isSet)}};
 
+ProcessingOptions::Option ProcessingOptions::lzInter{
+    false,
+    {"lzinter", "Use LZ77 compression with matches into the previous frame.", cxxopts::value(lzInter.isSet)}};
+
+ProcessingOptions::Option ProcessingOptions::rans{
+    false,
+    {"rans", "Use rANS entropy coding as the last compression step.", cxxopts::value(rans.isSet)}};
+
+ProcessingOptions::Option ProcessingOptions::lzOptimal{
+    false,
+    {"lzoptimal", "Use optimal parsing for smallest LZ-compressed output. Much slower.", cxxopts::value(lzOptimal.isSet)}};
+
+ProcessingOptions::OptionT<uint32_t> ProcessingOptions::lzChunk{
+    false,
+    {"lzchunk", "Split data into chunks of SIZE bytes that are LZ-compressed independently and in parallel. SIZE must be a multiple of 4 in [256, 16MB), e.g. \"--lzchunk=8192\".", cxxopts::value(lzChunk.value)},
+    0,
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(lzChunk.cxxOption.opts_))
+        {
+            REQUIRE(lzChunk.value >= 256 && lzChunk.value < (1 << 24) && lzChunk.value % 4 == 0, std::runtime_error, "LZ chunk size must be a multiple of 4 in [256, 16MB)");
+            lzChunk.isSet = true;
+        }
+    }};
+
 ProcessingOptions::Option ProcessingOptions::dxtg{
     false,
     {"dxtg", "Use DXT1-ish RGB555 compression.", cxxopts::value(dxtg.isSet)}};
@@ -213,6 +267,104 @@ ProcessingOptions::OptionT<std::vector<double>> ProcessingOptions::dxtv{
         }
     }};
 
+ProcessingOptions::Option ProcessingOptions::dxtClusterFit{
+    false,
+    {"dxtclusterfit", "Use the slower cluster fit instead of range fit to find DXTG / DXTV block colors. Reduces block errors considerably.", cxxopts::value(dxtClusterFit.isSet)}};
+
+ProcessingOptions::Option ProcessingOptions::parallelGops{
+    false,
+    {"parallelgops", "Encode groups of frames from one keyframe to the next in parallel. Needs a DXTV keyframe interval > 0 and can not be used with --deltaimage or --lzinter. Output is identical to serial encoding.", cxxopts::value(parallelGops.isSet)}};
+
+ProcessingOptions::OptionT<std::vector<uint32_t>> ProcessingOptions::decoder{
+    false,
+    {"decoder", "Video decoding options. Parameters are number of FFmpeg decoding threads in [0,64] (0 = automatic) and number of frames in [0,64] to decode in advance on a background thread (0 = none), e.g. \"--decoder=4,8\".", cxxopts::value(decoder.value)},
+    {0, 0},
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(decoder.cxxOption.opts_))
+        {
+            REQUIRE(decoder.value.size() == 2, std::runtime_error, "Decoder parameter format must be \"Threads, Read-ahead frames\", e.g. \"--decoder=4,8\"");
+            REQUIRE(decoder.value.at(0) <= 64, std::runtime_error, "Number of decoding threads must be in [0,64] (0 = automatic)");
+            REQUIRE(decoder.value.at(1) <= 64, std::runtime_error, "Number of read-ahead frames must be in [0,64] (0 = none)");
+            decoder.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<std::vector<uint32_t>> ProcessingOptions::resize{
+    false,
+    {"resize", "Scale video frames to size while decoding. Parameters are width and height in [1,1024], e.g. \"--resize=240,160\".", cxxopts::value(resize.value)},
+    {},
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(resize.cxxOption.opts_))
+        {
+            REQUIRE(resize.value.size() == 2, std::runtime_error, "Resize parameter format must be \"Width, Height\", e.g. \"--resize=240,160\"");
+            REQUIRE(resize.value.at(0) >= 1 && resize.value.at(0) <= 1024, std::runtime_error, "Width must be in [1,1024]");
+            REQUIRE(resize.value.at(1) >= 1 && resize.value.at(1) <= 1024, std::runtime_error, "Height must be in [1,1024]");
+            resize.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<std::vector<uint32_t>> ProcessingOptions::crop{
+    false,
+    {"crop", "Crop video frames to rectangle while decoding, before scaling. Parameters are left, top, width and height in pixels, e.g. \"--crop=0,60,640,360\".", cxxopts::value(crop.value)},
+    {},
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(crop.cxxOption.opts_))
+        {
+            REQUIRE(crop.value.size() == 4, std::runtime_error, "Crop parameter format must be \"Left, Top, Width, Height\", e.g. \"--crop=0,60,640,360\"");
+            REQUIRE(crop.value.at(2) >= 1 && crop.value.at(3) >= 1, std::runtime_error, "Crop width and height must be >= 1");
+            crop.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<double> ProcessingOptions::fps{
+    false,
+    {"fps", "Reduce video frame rate while decoding by dropping frames. Parameter is frame rate in (0,60] and must be <= input frame rate, e.g. \"--fps=15\".", cxxopts::value(fps.value)},
+    0,
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(fps.cxxOption.opts_))
+        {
+            REQUIRE(fps.value > 0 && fps.value <= 60, std::runtime_error, "Frame rate must be in (0,60]");
+            fps.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<std::vector<uint32_t>> ProcessingOptions::range{
+    false,
+    {"range", "Only read video frames in range. Parameters are first frame and end frame (exclusive, 0 = until end of video) of the input video, e.g. \"--range=300,900\".", cxxopts::value(range.value)},
+    {0, 0},
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(range.cxxOption.opts_))
+        {
+            REQUIRE(range.value.size() == 2, std::runtime_error, "Range parameter format must be \"First frame, End frame\", e.g. \"--range=300,900\"");
+            REQUIRE(range.value.at(1) == 0 || range.value.at(1) > range.value.at(0), std::runtime_error, "End frame must be > first frame (0 = until end of video)");
+            range.isSet = true;
+        }
+    }};
+
+ProcessingOptions::OptionT<uint32_t> ProcessingOptions::segments{
+    false,
+    {"segments", "Split video into segments at key frames and decode segments concurrently. Parameter is number of segments in [1,16], e.g. \"--segments=4\".", cxxopts::value(segments.value)},
+    1,
+    {},
+    [](const cxxopts::ParseResult &r)
+    {
+        if (r.count(segments.cxxOption.opts_))
+        {
+            REQUIRE(segments.value >= 1 && segments.value <= 16, std::runtime_error, "Number of segments must be in [1,16]");
+            segments.isSet = true;
+        }
+    }};
+
 ProcessingOptions::Option ProcessingOptions::gvid{
     false,
     {"gvid", "Use GVID video compression.", cxxopts::value(gvid.isSet)}};
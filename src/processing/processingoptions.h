@@ -44,10 +44,24 @@ public:
     static Option delta16;
     static Option lz10;
     static Option lz11;
-    // static Option rle;
+    static Option rle;
+    static OptionT<uint32_t> huffman;
+    static OptionT<double> compressBest;
+    static Option lzInter;
+    static Option rans;
     static Option vram;
+    static Option lzOptimal;
+    static OptionT<uint32_t> lzChunk;
     static Option dxtg;
     static OptionT<std::vector<double>> dxtv;
+    static Option dxtClusterFit;
+    static Option parallelGops;
+    static OptionT<std::vector<uint32_t>> decoder;
+    static OptionT<std::vector<uint32_t>> resize;
+    static OptionT<std::vector<uint32_t>> crop;
+    static OptionT<double> fps;
+    static OptionT<std::vector<uint32_t>> range;
+    static OptionT<uint32_t> segments;
     static Option gvid;
     static Option interleavePixels;
     static Option dryRun;
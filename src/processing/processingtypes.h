@@ -25,7 +25,11 @@ namespace Image
         DeltaImage = 55,       // Calculate signed pixel difference between successive images
         CompressLz10 = 60,     // Compress image data using LZ77 variant 10
         CompressLz11 = 61,     // Compress image data using LZ77 variant 11
+        CompressLzInter = 62,  // Compress image data using LZ77 with matches into the previous image data
         CompressRLE = 65,      // Compress image data using run-length-encoding
+        CompressHuffman = 66,  // Compress image data using 4- or 8-bit Huffman encoding
+        CompressBest = 67,     // Compress image data using the best of multiple compression types. The type chosen is stored instead of this
+        CompressRANS = 68,     // Compress image data using rANS entropy coding
         CompressDXTG = 70,     // Compress image data using DXTG
         CompressDXTV = 71,     // Compress image data using DXTV
         CompressGVID = 72,     // Compress image data using GVID
@@ -1,31 +1,86 @@
 #include "statistics.h"
 
+#include <iomanip>
+
 namespace Statistics
 {
 
     auto Container::addValue(const std::string &id, double v) -> void
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_values[id].push_back(v);
     }
 
     auto Container::addImage(const std::string &id, const std::vector<uint8_t> &image, Image::ColorFormat colorFormat, uint32_t width, uint32_t height) -> void
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_images[id] = {image, colorFormat, width, height};
     }
 
     auto Container::addImage(const std::string &id, std::vector<uint8_t> &&image, Image::ColorFormat colorFormat, uint32_t width, uint32_t height) -> void
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         m_images[id] = {std::move(image), colorFormat, width, height};
     }
 
-    auto Container::getValues() const -> const std::map<std::string, std::vector<double>> &
+    auto Container::addTiming(uint32_t stepIndex, const std::string &description, double seconds, uint64_t bytesIn, uint64_t bytesOut, uint64_t calls) -> void
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &timing = m_timings[stepIndex];
+        timing.description = description;
+        timing.calls += calls;
+        timing.seconds += seconds;
+        timing.bytesIn += bytesIn;
+        timing.bytesOut += bytesOut;
+    }
+
+    auto Container::getValues() const -> std::map<std::string, std::vector<double>>
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
         return m_values;
     }
 
-    auto Container::getImages() const -> const std::map<std::string, ImageData> &
+    auto Container::getImages() const -> std::map<std::string, ImageData>
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
         return m_images;
     }
 
+    auto Container::getTimings() const -> std::map<uint32_t, StepTiming>
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_timings;
+    }
+
+    auto Container::printTimings(std::ostream &os) const -> void
+    {
+        const auto timings = getTimings();
+        double totalSeconds = 0;
+        for (const auto &t : timings)
+        {
+            totalSeconds += t.second.seconds;
+        }
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::left << std::setw(28) << "Step" << std::right << std::setw(8) << "Calls" << std::setw(10) << "Time (s)" << std::setw(8) << "Time %" << std::setw(10) << "ms/call"
+           << std::setw(12) << "In (KB)" << std::setw(12) << "Out (KB)" << std::setw(8) << "Ratio" << std::setw(10) << "MB/s" << std::endl;
+        os << std::fixed;
+        for (const auto &t : timings)
+        {
+            const auto &timing = t.second;
+            // throughput is input bytes per second of step run time
+            const double msPerCall = timing.calls > 0 ? 1000 * timing.seconds / timing.calls : 0;
+            const double ratio = timing.bytesIn > 0 ? static_cast<double>(timing.bytesOut) / timing.bytesIn : 0;
+            const double throughput = timing.seconds > 0 ? timing.bytesIn / (1024 * 1024 * timing.seconds) : 0;
+            os << std::left << std::setw(28) << timing.description.substr(0, 27) << std::right << std::setw(8) << timing.calls;
+            os << std::setprecision(3) << std::setw(10) << timing.seconds << std::setprecision(1) << std::setw(8) << (totalSeconds > 0 ? 100 * timing.seconds / totalSeconds : 0);
+            os << std::setprecision(3) << std::setw(10) << msPerCall;
+            os << std::setprecision(1) << std::setw(12) << timing.bytesIn / 1024.0 << std::setw(12) << timing.bytesOut / 1024.0;
+            os << std::setprecision(3) << std::setw(8) << ratio << std::setprecision(1) << std::setw(10) << throughput << std::endl;
+        }
+        os << std::left << std::setw(28) << "Total" << std::right << std::setw(8) << "" << std::setprecision(3) << std::setw(10) << totalSeconds << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
+
 }
@@ -5,12 +5,15 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
 #include <vector>
 
 namespace Statistics
 {
 
+    /// @brief Container for statistics values and images. All functions are thread-safe
     class Container
     {
     public:
@@ -24,18 +27,38 @@ namespace Statistics
             uint32_t height = 0;
         };
 
+        /// @brief Accumulated run time and throughput of a processing step
+        struct StepTiming
+        {
+            std::string description;
+            uint64_t calls = 0;
+            double seconds = 0; // Sum of wall time of all calls
+            uint64_t bytesIn = 0;
+            uint64_t bytesOut = 0;
+        };
+
         auto addValue(const std::string &id, double v) -> void;
 
         auto addImage(const std::string &id, const std::vector<uint8_t> &image, Image::ColorFormat colorFormat, uint32_t width, uint32_t height) -> void;
 
         auto addImage(const std::string &id, std::vector<uint8_t> &&image, Image::ColorFormat colorFormat, uint32_t width, uint32_t height) -> void;
 
-        auto getValues() const -> const std::map<std::string, std::vector<double>> &;
-        auto getImages() const -> const std::map<std::string, ImageData> &;
+        /// @brief Add run time and data sizes of call(s) to processing step to the step timing
+        /// @param stepIndex Index of step in processing pipeline. Used to sort timings
+        auto addTiming(uint32_t stepIndex, const std::string &description, double seconds, uint64_t bytesIn, uint64_t bytesOut, uint64_t calls = 1) -> void;
+
+        auto getValues() const -> std::map<std::string, std::vector<double>>;
+        auto getImages() const -> std::map<std::string, ImageData>;
+        auto getTimings() const -> std::map<uint32_t, StepTiming>;
+
+        /// @brief Print table with timing and throughput of all processing steps
+        auto printTimings(std::ostream &os) const -> void;
 
     private:
+        mutable std::mutex m_mutex;
         std::map<std::string, std::vector<double>> m_values;
         std::map<std::string, ImageData> m_images;
+        std::map<uint32_t, StepTiming> m_timings;
     };
 
 }
@@ -1,6 +1,8 @@
 #include "color/colorhelpers.h"
 #include "compression/lzss.h"
+#include "processing/boundedqueue.h"
 #include "processing/datahelpers.h"
+#include "processing/decodecost.h"
 #include "io/textio.h"
 #include "processing/imagehelpers.h"
 #include "io/streamio.h"
@@ -12,14 +14,20 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <filesystem>
+#include <thread>
 
 #include "cxxopts/include/cxxopts.hpp"
 #include <Magick++.h>
+#include <omp.h>
 
 enum class ConversionMode
 {
@@ -30,6 +38,9 @@ enum class ConversionMode
 };
 ConversionMode m_conversionMode = ConversionMode::None;
 
+// Max. number of frames buffered between pipeline stages
+constexpr std::size_t PipelineQueueSize = 8;
+
 std::string m_inFile;
 std::string m_outFile;
 ProcessingOptions options;
@@ -70,11 +81,24 @@ bool readArguments(int argc, const char *argv[])
         opts.add_option("", options.delta16.cxxOption);
         opts.add_option("", options.dxtg.cxxOption);
         opts.add_option("", options.dxtv.cxxOption);
+        opts.add_option("", options.dxtClusterFit.cxxOption);
+        opts.add_option("", options.parallelGops.cxxOption);
+        opts.add_option("", options.decoder.cxxOption);
+        opts.add_option("", options.resize.cxxOption);
+        opts.add_option("", options.crop.cxxOption);
+        opts.add_option("", options.fps.cxxOption);
+        opts.add_option("", options.range.cxxOption);
+        opts.add_option("", options.segments.cxxOption);
         // opts.add_option("", options.gvid.cxxOption);
-        // opts.add_option("", options.rle.cxxOption);
+        opts.add_option("", options.rle.cxxOption);
+        opts.add_option("", options.huffman.cxxOption);
+        opts.add_option("", options.compressBest.cxxOption);
+        opts.add_option("", options.lzInter.cxxOption);
+        opts.add_option("", options.rans.cxxOption);
         opts.add_option("", options.lz10.cxxOption);
         opts.add_option("", options.lz11.cxxOption);
         opts.add_option("", options.vram.cxxOption);
+        opts.add_option("", options.lzOptimal.cxxOption);
         opts.add_option("", options.dryRun.cxxOption);
         opts.parse_positional({"infile", "outname"});
         auto result = opts.parse(argc, argv);
@@ -134,12 +158,51 @@ bool readArguments(int argc, const char *argv[])
             std::cerr << "Only a single LZ-compression option is allowed." << std::endl;
             return false;
         }
+        options.huffman.parse(result);
+        if (options.huffman && (options.lz10 || options.lz11))
+        {
+            std::cerr << "Huffman compression can not be combined with LZ-compression." << std::endl;
+            return false;
+        }
+        options.compressBest.parse(result);
+        if (options.compressBest && (options.rle || options.huffman || options.lz10 || options.lz11))
+        {
+            std::cerr << "Automatic compression selection can not be combined with other compression options." << std::endl;
+            return false;
+        }
+        // the GBA decoder keeps the previous frame in the scratch pad. more compression steps would overwrite it
+        if (options.lzInter && (options.rle || options.huffman || options.compressBest || options.lz10 || options.lz11))
+        {
+            std::cerr << "Inter-frame LZ compression can not be combined with other compression options." << std::endl;
+            return false;
+        }
+        if (options.rans && (options.huffman || options.compressBest || options.lzInter))
+        {
+            std::cerr << "rANS compression can not be combined with Huffman, automatic or inter-frame LZ compression." << std::endl;
+            return false;
+        }
         options.addColor0.parse(result);
         options.moveColor0.parse(result);
         options.shiftIndices.parse(result);
         options.pruneIndices.parse(result);
         options.sprites.parse(result);
         options.dxtv.parse(result);
+        options.decoder.parse(result);
+        options.resize.parse(result);
+        options.crop.parse(result);
+        options.fps.parse(result);
+        options.range.parse(result);
+        options.segments.parse(result);
+        if (options.dxtClusterFit && !(options.dxtg || options.dxtv))
+        {
+            std::cerr << "Cluster fit needs DXTG or DXTV compression." << std::endl;
+            return false;
+        }
+        if (options.parallelGops && (!options.dxtv || static_cast<int32_t>(options.dxtv.value.at(0)) == 0 || options.deltaImage || options.lzInter))
+        {
+            std::cerr << "Parallel GOP encoding needs DXTV compression with a keyframe interval > 0 and can not be used with delta image or LZ inter-frame encoding." << std::endl;
+            return false;
+        }
     }
     catch (const cxxopts::OptionException &e)
     {
@@ -171,23 +234,35 @@ void printUsage()
     std::cout << "IMAGE COMPRESSION options (mutually exclusive):" << std::endl;
     std::cout << options.dxtg.helpString() << std::endl;
     std::cout << options.dxtv.helpString() << std::endl;
+    std::cout << options.dxtClusterFit.helpString() << std::endl;
     // std::cout << options.gvid.helpString() << std::endl;
     std::cout << "COMPRESSION options (mutually exclusive):" << std::endl;
-    // std::cout << options.rle.helpString() << std::endl;
+    std::cout << options.rle.helpString() << std::endl;
+    std::cout << options.huffman.helpString() << std::endl;
+    std::cout << options.compressBest.helpString() << std::endl;
+    std::cout << options.lzInter.helpString() << std::endl;
+    std::cout << options.rans.helpString() << std::endl;
     std::cout << options.lz10.helpString() << std::endl;
     std::cout << options.lz11.helpString() << std::endl;
     std::cout << "COMPRESSION modifiers (optional):" << std::endl;
     std::cout << options.vram.helpString() << std::endl;
-    std::cout << "You must have DevkitPro installed or the gbalzss executable must be in PATH." << std::endl;
+    std::cout << options.lzOptimal.helpString() << std::endl;
     std::cout << "INFILE: Input video file to convert, e.g. \"foo.avi\"" << std::endl;
     std::cout << "OUTNAME: is determined from the first non-existant file path. It can be an " << std::endl;
     std::cout << "absolute or relative file path or a file base name. Two files OUTNAME.h and " << std::endl;
     std::cout << "OUTNAME.c will be generated. All variables will begin with the base name " << std::endl;
     std::cout << "portion of OUTNAME." << std::endl;
     std::cout << "MISC options (all optional):" << std::endl;
+    std::cout << options.parallelGops.helpString() << std::endl;
+    std::cout << options.decoder.helpString() << std::endl;
+    std::cout << options.resize.helpString() << std::endl;
+    std::cout << options.crop.helpString() << std::endl;
+    std::cout << options.fps.helpString() << std::endl;
+    std::cout << options.range.helpString() << std::endl;
+    std::cout << options.segments.helpString() << std::endl;
     std::cout << options.dryRun.helpString() << std::endl;
     std::cout << "ORDER: input, color conversion, addcolor0, movecolor0, shift, sprites, tiles," << std::endl;
-    std::cout << "deltaimage, dxtg / dtxv / gvid, delta8 / delta16, rle, lz10 / lz11, output" << std::endl;
+    std::cout << "deltaimage, dxtg / dtxv / gvid, delta8 / delta16, rle, huffman, lz10 / lz11, output" << std::endl;
 }
 
 int main(int argc, const char *argv[])
@@ -216,13 +291,60 @@ int main(int argc, const char *argv[])
         // fire up video reader and open video file
         VideoReader videoReader;
         VideoReader::VideoInfo videoInfo;
+        std::vector<std::unique_ptr<VideoReader>> segmentReaders;
         try
         {
             std::cout << "Opening " << m_inFile << "..." << std::endl;
-            videoReader.open(m_inFile);
+            VideoReader::DecodeOptions decodeOptions;
+            decodeOptions.nrOfThreads = options.decoder.value.at(0);
+            decodeOptions.readAheadFrames = options.decoder.value.at(1);
+            if (options.crop)
+            {
+                decodeOptions.crop = {options.crop.value.at(0), options.crop.value.at(1), options.crop.value.at(2), options.crop.value.at(3)};
+            }
+            if (options.resize)
+            {
+                decodeOptions.width = options.resize.value.at(0);
+                decodeOptions.height = options.resize.value.at(1);
+            }
+            decodeOptions.fps = options.fps ? options.fps.value : 0;
+            decodeOptions.startFrame = options.range.value.at(0);
+            decodeOptions.endFrame = options.range.value.at(1);
+            videoReader.open(m_inFile, decodeOptions);
             videoInfo = videoReader.getInfo();
             std::cout << "Video stream #" << videoInfo.videoStreamIndex << ": " << videoInfo.codecName << ", " << videoInfo.width << "x" << videoInfo.height << "@" << videoInfo.fps;
             std::cout << ", duration " << videoInfo.durationS << "s, " << videoInfo.nrOfFrames << " frames" << std::endl;
+            if (options.segments.value > 1)
+            {
+                // split frame range into segments that start at key frames, so every segment can be decoded on its own
+                const auto keyFrames = VideoReader::findKeyFrames(m_inFile);
+                std::vector<uint64_t> rangeKeyFrames;
+                std::copy_if(keyFrames.cbegin(), keyFrames.cend(), std::back_inserter(rangeKeyFrames), [&decodeOptions](auto f)
+                             { return f > decodeOptions.startFrame && (decodeOptions.endFrame == 0 || f < decodeOptions.endFrame); });
+                std::vector<uint64_t> segmentStarts = {decodeOptions.startFrame};
+                for (std::size_t si = 1; si < options.segments.value; si++)
+                {
+                    const auto ki = (si * (rangeKeyFrames.size() + 1)) / options.segments.value;
+                    if (ki > 0 && rangeKeyFrames.at(ki - 1) > segmentStarts.back())
+                    {
+                        segmentStarts.push_back(rangeKeyFrames.at(ki - 1));
+                    }
+                }
+                // open one reader per segment. the reader opened above is not needed anymore
+                if (segmentStarts.size() > 1)
+                {
+                    videoReader.close();
+                    for (std::size_t si = 0; si < segmentStarts.size(); si++)
+                    {
+                        auto segmentOptions = decodeOptions;
+                        segmentOptions.startFrame = segmentStarts.at(si);
+                        segmentOptions.endFrame = si + 1 < segmentStarts.size() ? segmentStarts.at(si + 1) : decodeOptions.endFrame;
+                        segmentReaders.push_back(std::make_unique<VideoReader>());
+                        segmentReaders.back()->open(m_inFile, segmentOptions);
+                    }
+                    std::cout << "Decoding " << segmentReaders.size() << " segments concurrently" << std::endl;
+                }
+            }
         }
         catch (const std::runtime_error &e)
         {
@@ -287,11 +409,11 @@ int main(int argc, const char *argv[])
         }
         if (options.dxtg)
         {
-            processing.addStep(Image::ProcessingType::CompressDXTG, {}, true, true);
+            processing.addStep(Image::ProcessingType::CompressDXTG, {options.dxtClusterFit.isSet}, true, true);
         }
         if (options.dxtv)
         {
-            processing.addStep(Image::ProcessingType::CompressDXTV, {options.dxtv.value.at(0), options.dxtv.value.at(1)}, true, true);
+            processing.addStep(Image::ProcessingType::CompressDXTV, {options.dxtv.value.at(0), options.dxtv.value.at(1), options.dxtClusterFit.isSet}, true, true);
         }
         if (options.gvid)
         {
@@ -305,17 +427,33 @@ int main(int argc, const char *argv[])
         {
             processing.addStep(Image::ProcessingType::ConvertDelta16, {});
         }
-        /*if (options.rle)
+        if (options.rle)
         {
             processing.addStep(Image::ProcessingType::CompressRLE, {options.vram.isSet}, true);
-        }*/
+        }
+        if (options.huffman)
+        {
+            processing.addStep(Image::ProcessingType::CompressHuffman, {options.huffman.value}, true);
+        }
+        if (options.compressBest)
+        {
+            processing.addStep(Image::ProcessingType::CompressBest, {options.vram.isSet, options.lzOptimal.isSet, options.compressBest.value}, true);
+        }
+        if (options.lzInter)
+        {
+            processing.addStep(Image::ProcessingType::CompressLzInter, {}, true);
+        }
         if (options.lz10)
         {
-            processing.addStep(Image::ProcessingType::CompressLz10, {options.vram.isSet}, true);
+            processing.addStep(Image::ProcessingType::CompressLz10, {options.vram.isSet, options.lzOptimal.isSet}, true);
         }
         if (options.lz11)
         {
-            processing.addStep(Image::ProcessingType::CompressLz11, {options.vram.isSet}, true);
+            processing.addStep(Image::ProcessingType::CompressLz11, {options.vram.isSet, options.lzOptimal.isSet}, true);
+        }
+        if (options.rans)
+        {
+            processing.addStep(Image::ProcessingType::CompressRANS, {}, true);
         }
         processing.addStep(Image::ProcessingType::PadImageData, {uint32_t(4)});
         // create statistics window
@@ -324,48 +462,7 @@ int main(int argc, const char *argv[])
         // apply image processing pipeline
         const auto processingDescription = processing.getProcessingDescription();
         std::cout << "Applying processing: " << processingDescription << std::endl;
-        // start reading frames from video
-        uint32_t lastProgress = 0;
-        auto startTime = std::chrono::steady_clock::now();
-        uint32_t frameIndex = 0;
-        std::vector<Image::Data> images;
-        do
-        {
-            auto frame = videoReader.readFrame();
-            if (frame.empty())
-            {
-                break;
-            }
-            REQUIRE(frame.size() == videoInfo.width * videoInfo.height * 3, std::runtime_error, "Unexpected frame size");
-            // build image from frame and apply processing
-            images.push_back(processing.processStream(Magick::Image(videoInfo.width, videoInfo.height, "RGB", Magick::StorageType::CharPixel, frame.data()), frameIndex++));
-            // calculate progress
-            uint32_t newProgress = ((100 * images.size()) / videoInfo.nrOfFrames);
-            if (lastProgress != newProgress)
-            {
-                lastProgress = newProgress;
-                auto newTime = std::chrono::steady_clock::now();
-                auto timePassedMs = std::chrono::duration<double>(newTime - startTime);
-                auto fps = static_cast<double>(images.size()) / timePassedMs.count();
-                auto restS = (videoInfo.nrOfFrames - images.size()) / fps;
-                std::cout << std::fixed << std::setprecision(1) << lastProgress << "%, " << fps << " fps, " << restS << "s remaining" << std::endl;
-            }
-            // update statistics
-            window.update();
-        } while (true);
-        // set up some image info
-        const auto imgType = images.front().type;
-        auto imgSize = images.front().size;
-        const bool allColorMapsSame = false;
-        const uint32_t maxColorMapColors = options.paletted ? (options.pruneIndices ? 16 : (options.paletted.value + (options.addColor0 ? 1 : 0))) : 0;
-        // output some info about data
-        const auto inputSize = videoInfo.width * videoInfo.height * 3 * videoInfo.nrOfFrames;
-        std::cout << "Input size: " << static_cast<double>(inputSize) / (1024 * 1024) << " MB" << std::endl;
-        const auto compressedSize = std::accumulate(images.cbegin(), images.cend(), 0, [](const auto &v, const auto &img)
-                                                    { return v + img.data.size() + (options.paletted ? img.colorMap.size() * 2 : 0); });
-        std::cout << "Compressed size: " << std::fixed << std::setprecision(2) << static_cast<double>(compressedSize) / (1024 * 1024) << " MB" << std::endl;
-        std::cout << "Avg. bit rate: " << std::fixed << std::setprecision(2) << (static_cast<double>(compressedSize) / 1024) / videoInfo.durationS << " kB/s" << std::endl;
-        std::cout << "Avg. frame size: " << std::fixed << std::setprecision(1) << static_cast<double>(compressedSize) / images.size() << " Byte" << std::endl;
+        // the file header stores integer frame rates only
         if (videoInfo.fps > 255 || (videoInfo.fps - std::round(videoInfo.fps)) != 0)
         {
             std::cout << "Frame rate of " << std::fixed << std::setprecision(2) << videoInfo.fps << " will be set to ";
@@ -373,37 +470,375 @@ int main(int argc, const char *argv[])
             videoInfo.fps = videoInfo.fps > 255 ? 255 : videoInfo.fps;
             std::cout << videoInfo.fps << std::endl;
         }
-        // find out the max. memory needed to decompress
-        const auto maxMemoryNeeded = std::max_element(images.cbegin(), images.cend(), [](const auto &img0, const auto &img1)
-                                                      { return img0.maxMemoryNeeded < img1.maxMemoryNeeded; })
-                                         ->maxMemoryNeeded;
-        std::cout << "Max. intermediate memory for decompression: " << maxMemoryNeeded << " Byte" << std::endl;
         // check if we want to write output files
+        std::ofstream binFile;
+        std::unique_ptr<Image::IO::StreamWriter> writer;
         if (!options.dryRun)
         {
             // open output file
-            std::ofstream binFile(m_outFile + ".bin", std::ios::out | std::ios::binary);
-            if (binFile.is_open())
+            binFile.open(m_outFile + ".bin", std::ios::out | std::ios::binary);
+            if (!binFile.is_open())
+            {
+                std::cerr << "Failed to open " << m_outFile << ".bin for writing" << std::endl;
+                return 1;
+            }
+            std::cout << "Writing output file " << m_outFile << ".bin" << std::endl;
+            writer = std::make_unique<Image::IO::StreamWriter>(binFile, static_cast<uint8_t>(videoInfo.fps));
+        }
+        // split processing into stages that run on their own threads and are connected by bounded queues:
+        // video decoding -> input conversion -> stateless steps -> stateful codec step -> remaining steps -> collecting frames
+        const auto stages = processing.getStreamStages();
+        REQUIRE(!stages.empty(), std::runtime_error, "Processing pipeline is empty");
+        BoundedQueue<std::vector<uint8_t>> decodedFrames(PipelineQueueSize);
+        // pool of frame buffers the decoder writes to. buffers are passed back after input processing, so no memory is allocated per frame
+        const std::size_t nrOfFrameBuffers = PipelineQueueSize + 2;
+        BoundedQueue<std::vector<uint8_t>> freeFrames(nrOfFrameBuffers);
+        for (std::size_t i = 0; i < nrOfFrameBuffers; i++)
+        {
+            freeFrames.push(std::vector<uint8_t>(videoInfo.width * videoInfo.height * 3));
+        }
+        // when decoding segments concurrently, every segment has its own queue and buffer pool, so a segment
+        // that is not being output yet can not take away the buffers the segment being output needs
+        std::vector<std::unique_ptr<BoundedQueue<std::vector<uint8_t>>>> segmentFrames;
+        std::vector<std::unique_ptr<BoundedQueue<std::vector<uint8_t>>>> segmentFreeFrames;
+        for (std::size_t si = 0; si < segmentReaders.size(); si++)
+        {
+            segmentFrames.push_back(std::make_unique<BoundedQueue<std::vector<uint8_t>>>(PipelineQueueSize));
+            segmentFreeFrames.push_back(std::make_unique<BoundedQueue<std::vector<uint8_t>>>(nrOfFrameBuffers));
+            for (std::size_t i = 0; i < nrOfFrameBuffers; i++)
+            {
+                segmentFreeFrames.back()->push(std::vector<uint8_t>(videoInfo.width * videoInfo.height * 3));
+            }
+        }
+        std::vector<std::unique_ptr<BoundedQueue<Image::Data>>> stageOutputs;
+        for (std::size_t i = 0; i < stages.size(); i++)
+        {
+            stageOutputs.push_back(std::make_unique<BoundedQueue<Image::Data>>(PipelineQueueSize));
+        }
+        // on error, store the first exception and close all queues so all stages stop
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        auto abortPipeline = [&]()
+        {
             {
-                std::cout << "Writing output file " << m_outFile << ".bin" << std::endl;
-                try
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
                 {
-                    Image::IO::writeFileHeader(binFile, images, static_cast<uint8_t>(videoInfo.fps), maxMemoryNeeded);
-                    Image::IO::writeFrames(binFile, images);
+                    error = std::current_exception();
                 }
-                catch (const std::runtime_error &e)
+            }
+            freeFrames.close();
+            decodedFrames.close();
+            std::for_each(segmentFrames.begin(), segmentFrames.end(), [](auto &q)
+                          { q->close(); });
+            std::for_each(segmentFreeFrames.begin(), segmentFreeFrames.end(), [](auto &q)
+                          { q->close(); });
+            std::for_each(stageOutputs.begin(), stageOutputs.end(), [](auto &q)
+                          { q->close(); });
+        };
+        // decode video frames into recycled frame buffers
+        auto decodeFrames = [&]()
+        {
+            try
+            {
+                while (auto frame = freeFrames.pop())
                 {
-                    binFile.close();
-                    std::cerr << "Failed to write data to output file: " << e.what() << std::endl;
-                    return 1;
+                    if (!videoReader.readFrame(*frame))
+                    {
+                        break;
+                    }
+                    if (!decodedFrames.push(std::move(*frame)))
+                    {
+                        break;
+                    }
                 }
+                decodedFrames.close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        // decode video frames of one segment into the recycled frame buffers of the segment
+        auto decodeSegment = [&](std::size_t si)
+        {
+            try
+            {
+                while (auto frame = segmentFreeFrames[si]->pop())
+                {
+                    if (!segmentReaders[si]->readFrame(*frame))
+                    {
+                        break;
+                    }
+                    if (!segmentFrames[si]->push(std::move(*frame)))
+                    {
+                        break;
+                    }
+                }
+                segmentFrames[si]->close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        // merge segments into one stream in frame order. frame buffers are swapped with the pipeline buffer pool,
+        // so the number of buffers in every pool stays the same and nothing is copied
+        auto mergeSegments = [&]()
+        {
+            try
+            {
+                for (std::size_t si = 0; si < segmentFrames.size(); si++)
+                {
+                    while (auto frame = segmentFrames[si]->pop())
+                    {
+                        auto freeFrame = freeFrames.pop();
+                        if (!freeFrame || !segmentFreeFrames[si]->push(std::move(*freeFrame)) || !decodedFrames.push(std::move(*frame)))
+                        {
+                            return;
+                        }
+                    }
+                }
+                decodedFrames.close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        // apply input processing to frame. truecolor and b/w input work on the frame pixels directly
+        auto convertFrames = [&]()
+        {
+            try
+            {
+                uint32_t frameIndex = 0;
+                while (auto frame = decodedFrames.pop())
+                {
+                    auto image = processing.processStream(frame->data(), videoInfo.width, videoInfo.height, frameIndex++, stages.front());
+                    // hand frame buffer back to decoder
+                    freeFrames.push(std::move(*frame));
+                    if (!stageOutputs.front()->push(std::move(image)))
+                    {
+                        break;
+                    }
+                }
+                stageOutputs.front()->close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        // apply processing steps of stage. every stage sees the frames in stream order
+        auto processFrames = [&](std::size_t si)
+        {
+            try
+            {
+                while (auto image = stageOutputs[si - 1]->pop())
+                {
+                    if (!stageOutputs[si]->push(processing.processStream(*image, stages[si])))
+                    {
+                        break;
+                    }
+                }
+                stageOutputs[si]->close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        // apply processing steps of stage with state to GOPs (frames from one key frame to the next) in parallel.
+        // GOPs don't depend on each other, so every worker encodes a whole GOP with a cleared state and the GOPs are output in order
+        auto processGops = [&](std::size_t si)
+        {
+            try
+            {
+                const auto keyFrameInterval = static_cast<uint32_t>(options.dxtv.value.at(0));
+                std::vector<Image::Processing> workers(omp_get_max_threads(), processing);
+                bool inputDone = false;
+                while (!inputDone)
+                {
+                    // collect one GOP per worker
+                    std::vector<std::vector<Image::Data>> gops;
+                    while (gops.size() < workers.size() || gops.back().size() < keyFrameInterval)
+                    {
+                        auto image = stageOutputs[si - 1]->pop();
+                        if (!image)
+                        {
+                            inputDone = true;
+                            break;
+                        }
+                        if (gops.empty() || (image->index % keyFrameInterval) == 0)
+                        {
+                            gops.emplace_back();
+                        }
+                        gops.back().push_back(std::move(*image));
+                    }
+                    // encode GOPs in parallel
+                    std::vector<std::exception_ptr> errors(gops.size());
+#pragma omp parallel for
+                    for (int gi = 0; gi < static_cast<int>(gops.size()); gi++)
+                    {
+                        try
+                        {
+                            auto &worker = workers[omp_get_thread_num()];
+                            worker.clearState();
+                            for (auto &image : gops[gi])
+                            {
+                                image = worker.processStream(image, stages[si]);
+                            }
+                        }
+                        catch (...)
+                        {
+                            errors[gi] = std::current_exception();
+                        }
+                    }
+                    auto errorIt = std::find_if(errors.cbegin(), errors.cend(), [](const auto &e)
+                                                { return e != nullptr; });
+                    if (errorIt != errors.cend())
+                    {
+                        std::rethrow_exception(*errorIt);
+                    }
+                    // output frames in stream order
+                    for (auto &gop : gops)
+                    {
+                        for (auto &image : gop)
+                        {
+                            if (!stageOutputs[si]->push(std::move(image)))
+                            {
+                                return;
+                            }
+                        }
+                    }
+                }
+                stageOutputs[si]->close();
+            }
+            catch (...)
+            {
+                abortPipeline();
+            }
+        };
+        std::vector<std::thread> threads;
+        if (segmentReaders.empty())
+        {
+            threads.emplace_back(decodeFrames);
+        }
+        else
+        {
+            for (std::size_t si = 0; si < segmentReaders.size(); si++)
+            {
+                threads.emplace_back(decodeSegment, si);
+            }
+            threads.emplace_back(mergeSegments);
+        }
+        threads.emplace_back(convertFrames);
+        for (std::size_t si = 1; si < stages.size(); si++)
+        {
+            if (options.parallelGops && processing.hasState(stages[si]))
+            {
+                threads.emplace_back(processGops, si);
             }
             else
             {
-                std::cerr << "Failed to open " << m_outFile << ".bin for writing" << std::endl;
-                return 1;
+                threads.emplace_back(processFrames, si);
             }
         }
+        // collect processed frames and write them to the output file as they come in
+        uint32_t lastProgress = 0;
+        auto startTime = std::chrono::steady_clock::now();
+        uint64_t nrOfFrames = 0;
+        uint64_t compressedSize = 0;
+        uint32_t maxMemoryNeeded = 0;
+        // estimated GBA decode time of frames vs. the time one frame is displayed
+        const double frameBudgetS = 1.0 / videoInfo.fps;
+        double decodeSumS = 0;
+        double decodeMaxS = 0;
+        uint64_t decodeMaxFrame = 0;
+        std::vector<std::pair<uint64_t, double>> framesOverBudget;
+        uint64_t unsupportedFrames = 0;
+        try
+        {
+            while (auto image = stageOutputs.back()->pop())
+            {
+                if (writer)
+                {
+                    writer->writeFrame(*image);
+                }
+                const auto decodeEstimate = DecodeCost::estimateFrame(image->decodeOperations, image->data.size());
+                const auto decodeS = decodeEstimate.seconds();
+                decodeSumS += decodeS;
+                if (decodeMaxS < decodeS)
+                {
+                    decodeMaxS = decodeS;
+                    decodeMaxFrame = nrOfFrames;
+                }
+                if (decodeS > frameBudgetS)
+                {
+                    framesOverBudget.push_back({nrOfFrames, decodeS});
+                }
+                unsupportedFrames += decodeEstimate.supported ? 0 : 1;
+                nrOfFrames++;
+                compressedSize += image->data.size() + (options.paletted ? image->colorMap.size() * 2 : 0);
+                maxMemoryNeeded = maxMemoryNeeded < image->maxMemoryNeeded ? image->maxMemoryNeeded : maxMemoryNeeded;
+                // calculate progress
+                uint32_t newProgress = ((100 * nrOfFrames) / videoInfo.nrOfFrames);
+                if (lastProgress != newProgress)
+                {
+                    lastProgress = newProgress;
+                    auto newTime = std::chrono::steady_clock::now();
+                    auto timePassedMs = std::chrono::duration<double>(newTime - startTime);
+                    auto fps = static_cast<double>(nrOfFrames) / timePassedMs.count();
+                    auto restS = (videoInfo.nrOfFrames - nrOfFrames) / fps;
+                    std::cout << std::fixed << std::setprecision(1) << lastProgress << "%, " << fps << " fps, " << restS << "s remaining" << std::endl;
+                }
+                // update statistics
+                window.update();
+            }
+        }
+        catch (...)
+        {
+            abortPipeline();
+        }
+        std::for_each(threads.begin(), threads.end(), [](auto &t)
+                      { t.join(); });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        REQUIRE(nrOfFrames > 0, std::runtime_error, "No frames read from video");
+        // update file header with info only known now
+        if (writer)
+        {
+            writer->finish();
+        }
+        // output some info about data
+        const auto inputSize = videoInfo.width * videoInfo.height * 3 * videoInfo.nrOfFrames;
+        std::cout << "Input size: " << static_cast<double>(inputSize) / (1024 * 1024) << " MB" << std::endl;
+        std::cout << "Compressed size: " << std::fixed << std::setprecision(2) << static_cast<double>(compressedSize) / (1024 * 1024) << " MB" << std::endl;
+        std::cout << "Avg. bit rate: " << std::fixed << std::setprecision(2) << (static_cast<double>(compressedSize) / 1024) / videoInfo.durationS << " kB/s" << std::endl;
+        std::cout << "Avg. frame size: " << std::fixed << std::setprecision(1) << static_cast<double>(compressedSize) / nrOfFrames << " Byte" << std::endl;
+        std::cout << "Max. intermediate memory for decompression: " << maxMemoryNeeded << " Byte" << std::endl;
+        std::cout << "Est. GBA decode time: Avg. " << std::fixed << std::setprecision(2) << 1000 * decodeSumS / nrOfFrames << " ms, max. " << 1000 * decodeMaxS << " ms (frame " << decodeMaxFrame << "), budget " << 1000 * frameBudgetS << " ms / frame" << std::endl;
+        if (!framesOverBudget.empty())
+        {
+            constexpr std::size_t MaxFramesListed = 20;
+            std::cout << "Warning: " << framesOverBudget.size() << " frame(s) will likely take longer to decode than the frame time budget and stutter:" << std::endl;
+            for (std::size_t fi = 0; fi < framesOverBudget.size() && fi < MaxFramesListed; fi++)
+            {
+                std::cout << "  Frame " << framesOverBudget[fi].first << ": " << std::fixed << std::setprecision(2) << 1000 * framesOverBudget[fi].second << " ms" << std::endl;
+            }
+            if (framesOverBudget.size() > MaxFramesListed)
+            {
+                std::cout << "  ..." << std::endl;
+            }
+        }
+        if (unsupportedFrames > 0)
+        {
+            std::cout << "Warning: " << unsupportedFrames << " frame(s) contain data the GBA player can not decode" << std::endl;
+        }
+        // output where the time went. stages run concurrently, so step times add up to more than the wall time
+        window.getStatisticsContainer()->printTimings(std::cout);
         std::cout << "Done" << std::endl;
     }
     catch (const std::runtime_error &e)
@@ -0,0 +1,122 @@
+#include "compression/huffman.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/// @brief Reference decoder for BIOS Huffman data with 4- or 8-bit symbols. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+static auto decompressHuffman(const std::vector<uint8_t> &compressed) -> std::vector<uint8_t>
+{
+    REQUIRE(compressed.size() >= 8);
+    REQUIRE(compressed.size() % 4 == 0);
+    REQUIRE((compressed[0] & 0xF0) == 0x20);
+    const uint32_t bitsPerSymbol = compressed[0] & 0x0F;
+    REQUIRE((bitsPerSymbol == 4 || bitsPerSymbol == 8));
+    const uint32_t size = compressed[1] | (compressed[2] << 8) | (compressed[3] << 16);
+    // tree table starts with its size byte. the root node follows directly and the bit stream follows the table
+    const std::size_t rootAddress = 5;
+    const std::size_t tableEnd = 4 + (compressed[4] + 1) * 2;
+    std::size_t index = tableEnd;
+    REQUIRE(index % 4 == 0);
+    std::vector<uint8_t> data;
+    uint32_t symbolBits = 0;
+    uint32_t bitsInSymbol = 0;
+    std::size_t nodeAddress = rootAddress;
+    while (data.size() < size)
+    {
+        REQUIRE(index + 4 <= compressed.size());
+        const uint32_t word = compressed[index] | (compressed[index + 1] << 8) | (compressed[index + 2] << 16) | (static_cast<uint32_t>(compressed[index + 3]) << 24);
+        index += 4;
+        for (uint32_t bit = 32; bit-- > 0 && data.size() < size;)
+        {
+            // node: bits 0-5 = offset to child pair, bit 7 = child 0 is a leaf, bit 6 = child 1 is a leaf
+            const auto node = compressed[nodeAddress];
+            const uint32_t child = (word >> bit) & 1;
+            const auto childAddress = (nodeAddress & ~std::size_t(1)) + (node & 0x3F) * 2 + 2 + child;
+            if (childAddress >= tableEnd)
+            {
+                FAIL("Child node outside of tree table");
+            }
+            if ((node & (0x80 >> child)) == 0)
+            {
+                nodeAddress = childAddress;
+                continue;
+            }
+            // leaf. 4-bit symbols are stored lower nibble first
+            symbolBits |= static_cast<uint32_t>(compressed[childAddress]) << bitsInSymbol;
+            bitsInSymbol += bitsPerSymbol;
+            if (bitsInSymbol == 8)
+            {
+                data.push_back(static_cast<uint8_t>(symbolBits));
+                symbolBits = 0;
+                bitsInSymbol = 0;
+            }
+            nodeAddress = rootAddress;
+        }
+    }
+    return data;
+}
+
+/// @brief Build random data with geometrically distributed symbols
+static auto skewedData(std::mt19937 &generator, std::size_t size, double p) -> std::vector<uint8_t>
+{
+    std::geometric_distribution<uint32_t> distribution(p);
+    std::vector<uint8_t> data(size);
+    std::generate(data.begin(), data.end(), [&]()
+                  { return static_cast<uint8_t>(std::min(distribution(generator), uint32_t(255))); });
+    return data;
+}
+
+TEST_CASE("Huffman round-trips empty data and single symbols", "[huffman]")
+{
+    for (uint32_t bitsPerSymbol : {4, 8})
+    {
+        const std::vector<uint8_t> empty;
+        REQUIRE(decompressHuffman(Compression::compressHuffman(empty, bitsPerSymbol)) == empty);
+        // the tree is padded with an unused symbol, so there are two leaves
+        const std::vector<uint8_t> single(1000, 0x77);
+        REQUIRE(decompressHuffman(Compression::compressHuffman(single, bitsPerSymbol)) == single);
+        REQUIRE(decompressHuffman(Compression::compressHuffman({0x12}, bitsPerSymbol)) == std::vector<uint8_t>{0x12});
+    }
+}
+
+TEST_CASE("Huffman round-trips 4-bit symbols", "[huffman]")
+{
+    std::mt19937 generator(1234);
+    for (std::size_t size : {1, 3, 4, 5, 1000, 50000})
+    {
+        const auto data = skewedData(generator, size, 0.1);
+        REQUIRE(decompressHuffman(Compression::compressHuffman(data, 4)) == data);
+    }
+}
+
+TEST_CASE("Huffman round-trips 8-bit symbols", "[huffman]")
+{
+    std::mt19937 generator(2345);
+    std::uniform_int_distribution<uint32_t> uniform(0, 255);
+    for (std::size_t size : {1, 3, 4, 5, 1000, 50000})
+    {
+        const auto data = skewedData(generator, size, 0.05);
+        REQUIRE(decompressHuffman(Compression::compressHuffman(data, 8)) == data);
+        std::vector<uint8_t> random(size);
+        std::generate(random.begin(), random.end(), [&]()
+                      { return static_cast<uint8_t>(uniform(generator)); });
+        REQUIRE(decompressHuffman(Compression::compressHuffman(random, 8)) == random);
+    }
+}
+
+TEST_CASE("Huffman round-trips deep trees", "[huffman]")
+{
+    // exponentially falling frequencies build a degenerate tree with long codes, which stresses the node offset limit of the tree table
+    std::vector<uint8_t> data;
+    for (uint32_t s = 0; s < 256; s++)
+    {
+        data.insert(data.end(), s < 16 ? (1U << (16 - s)) : 1, static_cast<uint8_t>(s));
+    }
+    std::shuffle(data.begin(), data.end(), std::mt19937(3456));
+    REQUIRE(decompressHuffman(Compression::compressHuffman(data, 8)) == data);
+    REQUIRE(decompressHuffman(Compression::compressHuffman(data, 4)) == data);
+}
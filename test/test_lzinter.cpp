@@ -0,0 +1,90 @@
+#include "compression/lzinter.h"
+#include "video/lzinter.h"
+// sys/base.h defines a SECTION macro that clashes with the Catch macro
+#undef SECTION
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/// @brief Compress data against previous data with the host encoder and decompress it in-place over the previous data with the GBA decoder
+static auto lzInterRoundTrip(const std::vector<uint8_t> &data, const std::vector<uint8_t> &previous) -> std::vector<uint8_t>
+{
+    const auto compressed = Compression::compressLzInter(data, previous);
+    REQUIRE(compressed.size() % 4 == 0);
+    std::vector<uint32_t> source(compressed.size() / 4);
+    std::memcpy(source.data(), compressed.data(), compressed.size());
+    // the destination holds the previous data, like the scratch pad in the player
+    std::vector<uint32_t> destination((std::max(data.size(), previous.size()) + 3) / 4 + 1, 0);
+    std::copy(previous.cbegin(), previous.cend(), reinterpret_cast<uint8_t *>(destination.data()));
+    Decompress::LZInterUnCompWrite8bit(source.data(), destination.data());
+    const auto bytes = reinterpret_cast<const uint8_t *>(destination.data());
+    return std::vector<uint8_t>(bytes, bytes + data.size());
+}
+
+/// @brief Build random data with runs, so the encoder finds intra-frame matches
+static auto randomData(std::mt19937 &generator, std::size_t size) -> std::vector<uint8_t>
+{
+    std::uniform_int_distribution<uint32_t> value(0, 255);
+    std::uniform_int_distribution<uint32_t> runLength(1, 12);
+    std::vector<uint8_t> data;
+    while (data.size() < size)
+    {
+        const auto v = static_cast<uint8_t>(value(generator));
+        const auto length = std::min<std::size_t>(runLength(generator), size - data.size());
+        data.insert(data.end(), length, v);
+    }
+    return data;
+}
+
+/// @brief Change some bytes of data and shift a part of it, so the encoder finds inter-frame matches with offsets
+static auto modifiedData(std::mt19937 &generator, const std::vector<uint8_t> &previous) -> std::vector<uint8_t>
+{
+    std::uniform_int_distribution<std::size_t> position(0, previous.size() - 1);
+    std::uniform_int_distribution<uint32_t> value(0, 255);
+    auto data = previous;
+    for (std::size_t i = 0; i < previous.size() / 50; i++)
+    {
+        data[position(generator)] = static_cast<uint8_t>(value(generator));
+    }
+    std::rotate(data.begin() + data.size() / 2, data.begin() + data.size() / 2 + 7, data.end());
+    return data;
+}
+
+TEST_CASE("LZ inter round-trips without previous data", "[lzinter]")
+{
+    std::mt19937 generator(1234);
+    const auto data = randomData(generator, 10000);
+    REQUIRE(lzInterRoundTrip(data, {}) == data);
+    REQUIRE(Compression::decompressLzInter(Compression::compressLzInter(data, {}), {}) == data);
+}
+
+TEST_CASE("LZ inter round-trips with previous data of the same size", "[lzinter]")
+{
+    std::mt19937 generator(2345);
+    const auto previous = randomData(generator, 38400);
+    const auto data = modifiedData(generator, previous);
+    REQUIRE(lzInterRoundTrip(data, previous) == data);
+    REQUIRE(lzInterRoundTrip(previous, previous) == previous);
+}
+
+TEST_CASE("LZ inter round-trips with shorter previous data", "[lzinter]")
+{
+    std::mt19937 generator(3456);
+    const auto data = modifiedData(generator, randomData(generator, 20000));
+    const std::vector<uint8_t> previous(data.cbegin(), data.cbegin() + 12345);
+    REQUIRE(lzInterRoundTrip(data, previous) == data);
+}
+
+TEST_CASE("LZ inter round-trips with longer previous data", "[lzinter]")
+{
+    std::mt19937 generator(4567);
+    const auto previous = randomData(generator, 20000);
+    auto data = modifiedData(generator, previous);
+    data.resize(12345);
+    REQUIRE(lzInterRoundTrip(data, previous) == data);
+}
@@ -0,0 +1,187 @@
+#include "compression/lzss.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/// @brief Reference decoder for BIOS LZ77 variant 10 and 11 data. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+/// @param minDisplacement Fail if a match references data closer than this, e.g. 2 for VRAM-compatible data
+/// @param matchLengths If not nullptr the lengths of all matches are appended here
+static auto decompressLzss(const std::vector<uint8_t> &compressed, uint32_t minDisplacement = 1, std::vector<uint32_t> *matchLengths = nullptr) -> std::vector<uint8_t>
+{
+    REQUIRE(compressed.size() >= 4);
+    REQUIRE(compressed.size() % 4 == 0);
+    const uint32_t type = compressed[0];
+    REQUIRE((type == 0x10 || type == 0x11));
+    const uint32_t size = compressed[1] | (compressed[2] << 8) | (compressed[3] << 16);
+    std::vector<uint8_t> data;
+    std::size_t index = 4;
+    auto next = [&compressed, &index]() -> uint32_t
+    {
+        REQUIRE(index < compressed.size());
+        return compressed[index++];
+    };
+    while (data.size() < size)
+    {
+        const auto flags = next();
+        for (uint32_t bit = 0; bit < 8 && data.size() < size; bit++)
+        {
+            if ((flags & (0x80 >> bit)) == 0)
+            {
+                data.push_back(static_cast<uint8_t>(next()));
+                continue;
+            }
+            const auto b0 = next();
+            uint32_t length = 0;
+            uint32_t displacement = 0;
+            if (type == 0x10)
+            {
+                length = (b0 >> 4) + 3;
+                displacement = (((b0 & 0x0F) << 8) | next()) + 1;
+            }
+            else if ((b0 >> 4) == 0)
+            {
+                const auto b1 = next();
+                length = (((b0 & 0x0F) << 4) | (b1 >> 4)) + 0x11;
+                displacement = (((b1 & 0x0F) << 8) | next()) + 1;
+            }
+            else if ((b0 >> 4) == 1)
+            {
+                const auto b1 = next();
+                const auto b2 = next();
+                length = (((b0 & 0x0F) << 12) | (b1 << 4) | (b2 >> 4)) + 0x111;
+                displacement = (((b2 & 0x0F) << 8) | next()) + 1;
+            }
+            else
+            {
+                length = (b0 >> 4) + 1;
+                displacement = (((b0 & 0x0F) << 8) | next()) + 1;
+            }
+            REQUIRE(displacement >= minDisplacement);
+            REQUIRE(displacement <= data.size());
+            REQUIRE(data.size() + length <= size);
+            if (matchLengths != nullptr)
+            {
+                matchLengths->push_back(length);
+            }
+            for (uint32_t i = 0; i < length; i++)
+            {
+                data.push_back(data[data.size() - displacement]);
+            }
+        }
+    }
+    return data;
+}
+
+/// @brief Build random data with runs and repeated sequences, so the encoder finds matches with different displacements
+static auto randomData(std::mt19937 &generator, std::size_t size) -> std::vector<uint8_t>
+{
+    std::uniform_int_distribution<uint32_t> value(0, 255);
+    std::uniform_int_distribution<uint32_t> length(1, 40);
+    std::uniform_int_distribution<uint32_t> displacement(1, 5000);
+    std::vector<uint8_t> data;
+    while (data.size() < size)
+    {
+        const auto n = std::min<std::size_t>(length(generator), size - data.size());
+        const auto d = displacement(generator);
+        switch (value(generator) % 3)
+        {
+        case 0:
+            data.insert(data.end(), n, static_cast<uint8_t>(value(generator)));
+            break;
+        case 1:
+            for (std::size_t i = 0; i < n; i++)
+            {
+                data.push_back(d <= data.size() ? data[data.size() - d] : 0);
+            }
+            break;
+        default:
+            for (std::size_t i = 0; i < n; i++)
+            {
+                data.push_back(static_cast<uint8_t>(value(generator)));
+            }
+            break;
+        }
+    }
+    return data;
+}
+
+TEST_CASE("LZ77 round-trips in all modes", "[lzss]")
+{
+    std::mt19937 generator(1234);
+    for (std::size_t size : {0, 1, 2, 3, 17, 4096, 50000})
+    {
+        const auto data = randomData(generator, size);
+        for (bool lz11Compression : {false, true})
+        {
+            for (bool optimalParse : {false, true})
+            {
+                REQUIRE(decompressLzss(Compression::compressLzss(data, false, lz11Compression, optimalParse)) == data);
+                // VRAM-compatible data must never reference the byte directly before the current one
+                REQUIRE(decompressLzss(Compression::compressLzss(data, true, lz11Compression, optimalParse), 2) == data);
+            }
+        }
+    }
+}
+
+TEST_CASE("LZ11 round-trips all match length classes", "[lzss]")
+{
+    // run lengths at the borders of the 1-, 2- and 3-byte LZ11 match classes and beyond the maximum match length
+    std::mt19937 generator(2345);
+    std::uniform_int_distribution<uint32_t> value(0, 255);
+    std::vector<uint8_t> data;
+    for (uint32_t length : {0x10, 0x11, 0x12, 0x110, 0x111, 0x112, 0x10110, 0x10111, 0x20000})
+    {
+        data.push_back(static_cast<uint8_t>(value(generator)));
+        data.push_back(static_cast<uint8_t>(value(generator)));
+        data.insert(data.end(), length, static_cast<uint8_t>(value(generator)));
+    }
+    for (bool vramCompatible : {false, true})
+    {
+        for (bool optimalParse : {false, true})
+        {
+            std::vector<uint32_t> matchLengths;
+            REQUIRE(decompressLzss(Compression::compressLzss(data, vramCompatible, true, optimalParse), vramCompatible ? 2 : 1, &matchLengths) == data);
+            const auto [minIt, maxIt] = std::minmax_element(matchLengths.cbegin(), matchLengths.cend());
+            REQUIRE(*minIt >= 3);
+            REQUIRE(*maxIt == 0x10110);
+            REQUIRE(std::any_of(matchLengths.cbegin(), matchLengths.cend(), [](auto l)
+                                { return l >= 0x11 && l <= 0x110; }));
+        }
+    }
+}
+
+TEST_CASE("LZ77 chunks decompress independently", "[lzss]")
+{
+    std::mt19937 generator(3456);
+    const auto data = randomData(generator, 30000);
+    const auto [compressed, chunkStarts] = Compression::compressLzssChunked(data, true, true, false, 4096);
+    REQUIRE(chunkStarts.size() == (data.size() + 4095) / 4096);
+    std::vector<uint8_t> decompressed;
+    for (std::size_t ci = 0; ci < chunkStarts.size(); ci++)
+    {
+        REQUIRE(chunkStarts[ci] % 4 == 0);
+        const auto last = ci + 1 < chunkStarts.size() ? compressed.cbegin() + chunkStarts[ci + 1] : compressed.cend();
+        const auto chunk = decompressLzss(std::vector<uint8_t>(compressed.cbegin() + chunkStarts[ci], last), 2);
+        decompressed.insert(decompressed.end(), chunk.cbegin(), chunk.cend());
+    }
+    REQUIRE(decompressed == data);
+}
+
+TEST_CASE("LZ77 optimal parse is fast on an all-zero frame", "[lzss]")
+{
+    // a 240x160 16-bit frame. long runs used to make the optimal parse quadratic
+    const std::vector<uint8_t> data(240 * 160 * 2, 0);
+    for (bool lz11Compression : {false, true})
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto compressed = Compression::compressLzss(data, true, lz11Compression, true);
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        CHECK(duration.count() < 250);
+        REQUIRE(decompressLzss(compressed, 2) == data);
+    }
+}
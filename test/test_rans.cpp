@@ -0,0 +1,69 @@
+#include "compression/rans.h"
+#include "video/rans.h"
+// sys/base.h defines a SECTION macro that clashes with the Catch macro
+#undef SECTION
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/// @brief Compress data with the host encoder and decompress it with the GBA decoder
+static auto ransRoundTrip(const std::vector<uint8_t> &data) -> std::vector<uint8_t>
+{
+    const auto compressed = Compression::compressRans(data);
+    REQUIRE(compressed.size() % 4 == 0);
+    // the decoder reads 32-bit aligned source data and writes whole words
+    std::vector<uint32_t> source(compressed.size() / 4);
+    std::memcpy(source.data(), compressed.data(), compressed.size());
+    std::vector<uint32_t> destination((data.size() + 3) / 4 + 1, 0);
+    Decompress::RansUnCompWrite8bit(source.data(), destination.data());
+    const auto bytes = reinterpret_cast<const uint8_t *>(destination.data());
+    return std::vector<uint8_t>(bytes, bytes + data.size());
+}
+
+TEST_CASE("rANS round-trips empty data", "[rans]")
+{
+    const std::vector<uint8_t> data;
+    REQUIRE(ransRoundTrip(data) == data);
+    REQUIRE(Compression::decompressRans(Compression::compressRans(data)) == data);
+}
+
+TEST_CASE("rANS round-trips a single symbol", "[rans]")
+{
+    // the only symbol gets a frequency of 4096
+    const std::vector<uint8_t> data(1000, 0x5A);
+    REQUIRE(ransRoundTrip(data) == data);
+    REQUIRE(ransRoundTrip({0xFF}) == std::vector<uint8_t>{0xFF});
+}
+
+TEST_CASE("rANS round-trips skewed data", "[rans]")
+{
+    std::mt19937 generator(1234);
+    std::geometric_distribution<uint32_t> distribution(0.3);
+    std::vector<uint8_t> data(50000);
+    for (auto &v : data)
+    {
+        v = static_cast<uint8_t>(std::min(distribution(generator), uint32_t(255)));
+    }
+    REQUIRE(ransRoundTrip(data) == data);
+    REQUIRE(Compression::decompressRans(Compression::compressRans(data)) == data);
+}
+
+TEST_CASE("rANS round-trips random data", "[rans]")
+{
+    std::mt19937 generator(5678);
+    std::uniform_int_distribution<uint32_t> distribution(0, 255);
+    for (std::size_t size : {1, 3, 4, 255, 4097, 65536})
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &v : data)
+        {
+            v = static_cast<uint8_t>(distribution(generator));
+        }
+        REQUIRE(ransRoundTrip(data) == data);
+    }
+}
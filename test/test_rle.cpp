@@ -0,0 +1,91 @@
+#include "compression/rle.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/// @brief Reference decoder for BIOS RLE data. See: http://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
+static auto decompressRle(const std::vector<uint8_t> &compressed) -> std::vector<uint8_t>
+{
+    REQUIRE(compressed.size() >= 4);
+    REQUIRE(compressed.size() % 4 == 0);
+    REQUIRE(compressed[0] == 0x30);
+    const uint32_t size = compressed[1] | (compressed[2] << 8) | (compressed[3] << 16);
+    std::vector<uint8_t> data;
+    std::size_t index = 4;
+    while (data.size() < size)
+    {
+        REQUIRE(index < compressed.size());
+        const auto flag = compressed[index++];
+        if (flag & 0x80)
+        {
+            const uint32_t length = (flag & 0x7F) + 3;
+            REQUIRE(index < compressed.size());
+            REQUIRE(data.size() + length <= size);
+            data.insert(data.end(), length, compressed[index++]);
+        }
+        else
+        {
+            const uint32_t length = (flag & 0x7F) + 1;
+            REQUIRE(index + length <= compressed.size());
+            REQUIRE(data.size() + length <= size);
+            data.insert(data.end(), compressed.cbegin() + index, compressed.cbegin() + index + length);
+            index += length;
+        }
+    }
+    return data;
+}
+
+TEST_CASE("RLE round-trips empty data", "[rle]")
+{
+    const std::vector<uint8_t> data;
+    REQUIRE(decompressRle(Compression::compressRle(data, false)) == data);
+    REQUIRE(decompressRle(Compression::compressRle(data, true)) == data);
+}
+
+TEST_CASE("RLE round-trips runs at the block length limits", "[rle]")
+{
+    // runs shorter than 3 bytes are literals, runs longer than 0x82 bytes are split
+    std::vector<uint8_t> data;
+    uint8_t value = 0;
+    for (uint32_t length : {1, 2, 3, 4, 0x81, 0x82, 0x83, 0x104, 0x105, 1000})
+    {
+        data.insert(data.end(), length, value++);
+    }
+    REQUIRE(decompressRle(Compression::compressRle(data, false)) == data);
+}
+
+TEST_CASE("RLE round-trips long literal sequences", "[rle]")
+{
+    // literal blocks can hold at most 0x80 bytes
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<uint32_t> distribution(0, 255);
+    for (std::size_t size : {1, 0x7F, 0x80, 0x81, 0x100, 10000})
+    {
+        std::vector<uint8_t> data(size);
+        std::generate(data.begin(), data.end(), [&]()
+                      { return static_cast<uint8_t>(distribution(generator)); });
+        REQUIRE(decompressRle(Compression::compressRle(data, false)) == data);
+    }
+}
+
+TEST_CASE("RLE round-trips VRAM-compatible data", "[rle]")
+{
+    std::mt19937 generator(2345);
+    std::uniform_int_distribution<uint32_t> value(0, 3);
+    std::uniform_int_distribution<uint32_t> runLength(1, 200);
+    std::vector<uint8_t> data;
+    while (data.size() < 20000)
+    {
+        data.insert(data.end(), runLength(generator), static_cast<uint8_t>(value(generator)));
+    }
+    data.resize(20000);
+    REQUIRE(decompressRle(Compression::compressRle(data, true)) == data);
+    // the BIOS writes 16-bit units to VRAM, so odd sizes are rejected
+    data.pop_back();
+    REQUIRE_THROWS_AS(Compression::compressRle(data, true), std::runtime_error);
+}